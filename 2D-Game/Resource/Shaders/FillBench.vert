@@ -0,0 +1,18 @@
+#version 460 core
+
+// Full screen quad for --bench-fill. The texture repeats across the screen so that one screen
+// pixel covers texelsPerPixel texels, which is how minified it is when the camera zooms out.
+out vec2 TexCoord;
+
+uniform sampler2D ourTexture;
+uniform vec2 viewportSize;
+uniform float texelsPerPixel;
+
+const vec2 CORNERS[6] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
+void main()
+{
+    vec2 corner = CORNERS[gl_VertexID];
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+    TexCoord = corner * viewportSize * texelsPerPixel / vec2(textureSize(ourTexture, 0));
+}
@@ -1,12 +1,23 @@
 #version 460 core
 layout (location = 0) in vec2 Position;
-layout (location = 1) in vec2 aTexCoord;
+layout (location = 1) in vec2 aCorner;
 
 layout(std430, binding = 2) buffer Transform
 {
     mat4 transforms[];
 };
 
+layout(std430, binding = 3) readonly buffer Frames
+{
+    vec4 frameRects[];
+};
+
+// two 16 bit frame indices per uint
+layout(std430, binding = 4) readonly buffer SpriteFrames
+{
+    uint spriteFrames[];
+};
+
 out vec2 TexCoord;
 
 uniform mat4 view;
@@ -14,6 +25,11 @@ uniform mat4 projection;
 
 void main()
 {
-    gl_Position = projection * view * transforms[int(floor(gl_VertexID / 6))] * vec4(Position, 0.0, 1.0);
-    TexCoord = aTexCoord;
-}
\ No newline at end of file
+    int sprite = gl_VertexID / 6;
+    uint frame = (spriteFrames[sprite >> 1] >> ((sprite & 1) * 16)) & 0xFFFFu;
+    // clamped so a stale or corrupt index reads the last frame instead of past the table
+    vec4 rect = frameRects[min(frame, uint(frameRects.length()) - 1u)];
+
+    gl_Position = projection * view * transforms[sprite] * vec4(Position, 0.0, 1.0);
+    TexCoord = mix(rect.xy, rect.zw, aCorner);
+}
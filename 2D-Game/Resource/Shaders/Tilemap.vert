@@ -0,0 +1,35 @@
+#version 460 core
+
+layout(std430, binding = 3) readonly buffer Frames
+{
+    vec4 frameRects[];
+};
+
+// one uint per non-empty tile of the chunk: x in bits 0-7, y in bits 8-15, frame in bits 16-31
+layout(std430, binding = 5) readonly buffer ChunkTiles
+{
+    uint tiles[];
+};
+
+out vec2 TexCoord;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec2 chunkOrigin;
+uniform float tileSize;
+
+// two counter-clockwise triangles, corner (0, 0) is the tile's lower left
+const vec2 CORNERS[6] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(0.0, 1.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
+void main()
+{
+    uint tile = tiles[gl_VertexID / 6];
+    vec2 corner = CORNERS[gl_VertexID % 6];
+    vec2 cell = vec2(float(tile & 0xFFu), float((tile >> 8) & 0xFFu));
+    // packing drops tiles past the frame table, the clamp covers a sheet reloaded smaller since
+    vec4 rect = frameRects[min(tile >> 16, uint(frameRects.length()) - 1u)];
+
+    gl_Position = projection * view * vec4(chunkOrigin + (cell + corner) * tileSize, 0.0, 1.0);
+    // frame rects have v going down the sheet
+    TexCoord = mix(rect.xy, rect.zw, vec2(corner.x, 1.0 - corner.y));
+}
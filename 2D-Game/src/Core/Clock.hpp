@@ -0,0 +1,21 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// Monotonic clock counting integer nanoseconds since construction, so precision does not
+// degrade with uptime the way a float seconds counter does.
+class Clock {
+private:
+    std::chrono::steady_clock::time_point start;
+
+public:
+    Clock() : start(std::chrono::steady_clock::now()) {}
+
+    int64_t nanoseconds() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double seconds() const {
+        return double(nanoseconds()) * 1e-9;
+    }
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <climits>
+
+// Q16.16 fixed point: integer arithmetic only, so every compiler, optimization level and CPU
+// produces the same bits, which float cannot promise once contraction, reassociation or x87
+// come into play. Range is about +-32768 with a resolution of 1/65536.
+// Products and quotients go through 64 bits and round toward negative infinity (multiply) or
+// zero (divide), the same way everywhere. Overflow wraps like the integer it is.
+struct Fixed {
+    static constexpr int FRACTION_BITS = 16;
+    static constexpr int32_t ONE = 1 << FRACTION_BITS;
+
+    int32_t raw = 0;
+
+    static constexpr Fixed fromRaw(int32_t raw) {
+        Fixed f;
+        f.raw = raw;
+        return f;
+    }
+
+    static constexpr Fixed fromInt(int32_t value) {
+        return fromRaw(int32_t(uint32_t(value) << FRACTION_BITS));
+    }
+
+    // exact for any ratio representable in 1/65536 steps, the way constants should be written
+    static constexpr Fixed fromRatio(int32_t numerator, int32_t denominator) {
+        return fromRaw(int32_t(int64_t(numerator) * ONE / denominator));
+    }
+
+    // Only for loading data and debugging: the rounding of a float input is not portable,
+    // so the simulation itself never goes through float
+    static Fixed fromFloat(float value) {
+        return fromRaw(int32_t(value * float(ONE)));
+    }
+
+    float toFloat() const {
+        return float(raw) / float(ONE);
+    }
+
+    constexpr Fixed operator-() const { return fromRaw(-raw); }
+    constexpr Fixed operator+(Fixed o) const { return fromRaw(int32_t(uint32_t(raw) + uint32_t(o.raw))); }
+    constexpr Fixed operator-(Fixed o) const { return fromRaw(int32_t(uint32_t(raw) - uint32_t(o.raw))); }
+    constexpr Fixed operator*(Fixed o) const { return fromRaw(int32_t((int64_t(raw) * o.raw) >> FRACTION_BITS)); }
+    constexpr Fixed operator/(Fixed o) const { return fromRaw(int32_t(int64_t(raw) * ONE / o.raw)); }
+    Fixed& operator+=(Fixed o) { return *this = *this + o; }
+    Fixed& operator-=(Fixed o) { return *this = *this - o; }
+    Fixed& operator*=(Fixed o) { return *this = *this * o; }
+    Fixed& operator/=(Fixed o) { return *this = *this / o; }
+
+    constexpr bool operator==(Fixed o) const { return raw == o.raw; }
+    constexpr bool operator!=(Fixed o) const { return raw != o.raw; }
+    constexpr bool operator<(Fixed o) const { return raw < o.raw; }
+    constexpr bool operator<=(Fixed o) const { return raw <= o.raw; }
+    constexpr bool operator>(Fixed o) const { return raw > o.raw; }
+    constexpr bool operator>=(Fixed o) const { return raw >= o.raw; }
+};
+
+inline constexpr Fixed abs(Fixed f) {
+    return f.raw < 0 ? -f : f;
+}
+
+inline constexpr Fixed min(Fixed a, Fixed b) {
+    return a < b ? a : b;
+}
+
+inline constexpr Fixed max(Fixed a, Fixed b) {
+    return a < b ? b : a;
+}
+
+// Integer square root of the Q32.32 widening, bit by bit, exact to the last fraction bit
+inline Fixed sqrt(Fixed f) {
+    if (f.raw <= 0)
+        return Fixed();
+    uint64_t value = uint64_t(f.raw) << Fixed::FRACTION_BITS;
+    uint64_t result = 0;
+    uint64_t bit = uint64_t(1) << 62;
+    while (bit > value)
+        bit >>= 2;
+    while (bit)
+    {
+        if (value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+            result >>= 1;
+        bit >>= 2;
+    }
+    return Fixed::fromRaw(int32_t(result));
+}
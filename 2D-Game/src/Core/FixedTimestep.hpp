@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+// Accumulator for running the simulation at a fixed tick rate independent of the render rate.
+// Each frame feed it the real elapsed time, run the returned number of ticks with step(), then
+// render the state interpolated by alpha() between the previous and the current tick.
+class FixedTimestep {
+private:
+    double tickSeconds;
+    double accumulator = 0.0;
+    int maxTicksPerFrame;
+    uint64_t tickCount = 0;
+    uint64_t droppedTicks = 0;
+
+public:
+    // maxTicksPerFrame caps catch-up work so a slow frame cannot snowball into slower ones
+    FixedTimestep(double tickRate = 60.0, int maxTicksPerFrame = 8)
+        : tickSeconds(1.0 / tickRate), maxTicksPerFrame(maxTicksPerFrame) {}
+
+    int advance(double frameSeconds) {
+        accumulator += std::max(frameSeconds, 0.0);
+        int ticks = int(accumulator / tickSeconds);
+        if (ticks > maxTicksPerFrame)
+        {
+            // drop the backlog instead of simulating it, the game slows down rather than locking up
+            droppedTicks += uint64_t(ticks - maxTicksPerFrame);
+            ticks = maxTicksPerFrame;
+            accumulator = tickSeconds * ticks + std::fmod(accumulator, tickSeconds);
+        }
+        accumulator = std::max(accumulator - tickSeconds * ticks, 0.0);
+        tickCount += uint64_t(ticks);
+        return ticks;
+    }
+
+    // fraction of a tick left in the accumulator, 0 = previous state, 1 = current state
+    double alpha() const {
+        return accumulator / tickSeconds;
+    }
+
+    double step() const {
+        return tickSeconds;
+    }
+
+    void setTickRate(double tickRate) {
+        tickSeconds = 1.0 / tickRate;
+    }
+
+    uint64_t ticks() const {
+        return tickCount;
+    }
+
+    uint64_t dropped() const {
+        return droppedTicks;
+    }
+};
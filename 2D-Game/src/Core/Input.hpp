@@ -0,0 +1,271 @@
+#pragma once
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "Core/Clock.hpp"
+
+enum class InputDevice : uint8_t {
+    Key,
+    MouseButton,
+    GamepadButton,
+    GamepadAxis,  // code = axis * 2 + (1 for the positive direction), pressed past AXIS_THRESHOLD
+    Char,
+    CursorMove,
+    Scroll,
+};
+
+struct InputEvent {
+    double time;       // Clock seconds when the event arrived
+    InputDevice device;
+    bool down;         // press or release, buttons only
+    int32_t code;      // GLFW key / button code, codepoint for Char
+    glm::vec2 value;   // cursor position or scroll offset
+};
+
+// Lock-free single producer / single consumer ring. The producer is whoever runs the GLFW
+// callbacks, the consumer drains it once per simulation tick. Full rings drop new events.
+class InputEventQueue {
+private:
+    static constexpr uint32_t CAPACITY = 1024;
+    static constexpr uint32_t MASK = CAPACITY - 1;
+
+    InputEvent events[CAPACITY];
+    alignas(64) std::atomic<uint32_t> head{ 0 }; // next to read
+    alignas(64) std::atomic<uint32_t> tail{ 0 }; // next to write
+    uint64_t droppedEvents = 0;
+
+public:
+    bool push(const InputEvent& event) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY)
+        {
+            droppedEvents++;
+            return false;
+        }
+        events[t & MASK] = event;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    const InputEvent* peek() const {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return nullptr;
+        return &events[h & MASK];
+    }
+
+    void pop() {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    uint64_t dropped() const {
+        return droppedEvents;
+    }
+};
+
+// Flat table from (device, code) to an action index, resolved with one array lookup no matter how
+// many bindings exist. Several inputs can share an action; one input drives at most one action.
+class ActionMap {
+public:
+    static constexpr int MAX_ACTIONS = 32;
+    static constexpr int UNBOUND = -1;
+
+private:
+    static constexpr int KEY_CODES = GLFW_KEY_LAST + 1;
+    static constexpr int MOUSE_CODES = GLFW_MOUSE_BUTTON_LAST + 1;
+    static constexpr int GAMEPAD_BUTTON_CODES = GLFW_GAMEPAD_BUTTON_LAST + 1;
+    static constexpr int GAMEPAD_AXIS_CODES = (GLFW_GAMEPAD_AXIS_LAST + 1) * 2;
+    static constexpr int TABLE_SIZE = KEY_CODES + MOUSE_CODES + GAMEPAD_BUTTON_CODES + GAMEPAD_AXIS_CODES;
+
+    int8_t table[TABLE_SIZE];
+
+    static int slot(InputDevice device, int code) {
+        switch (device)
+        {
+        case InputDevice::Key:           return code >= 0 && code < KEY_CODES ? code : -1;
+        case InputDevice::MouseButton:   return code >= 0 && code < MOUSE_CODES ? KEY_CODES + code : -1;
+        case InputDevice::GamepadButton: return code >= 0 && code < GAMEPAD_BUTTON_CODES ? KEY_CODES + MOUSE_CODES + code : -1;
+        case InputDevice::GamepadAxis:   return code >= 0 && code < GAMEPAD_AXIS_CODES ? KEY_CODES + MOUSE_CODES + GAMEPAD_BUTTON_CODES + code : -1;
+        default:                         return -1;
+        }
+    }
+
+public:
+    ActionMap() {
+        std::memset(table, UNBOUND, sizeof(table));
+    }
+
+    bool bind(InputDevice device, int code, int action) {
+        int index = slot(device, code);
+        if (index < 0 || action < 0 || action >= MAX_ACTIONS)
+            return false;
+        table[index] = int8_t(action);
+        return true;
+    }
+
+    void unbind(InputDevice device, int code) {
+        int index = slot(device, code);
+        if (index >= 0)
+            table[index] = UNBOUND;
+    }
+
+    int action(InputDevice device, int code) const {
+        int index = slot(device, code);
+        return index < 0 ? UNBOUND : table[index];
+    }
+};
+
+// Actions for one tick as bitmasks indexed by action
+struct ActionFrame {
+    uint32_t held = 0;     // down at the end of the tick
+    uint32_t pressed = 0;  // went down during the tick, set even if released again before it ended
+    uint32_t released = 0;
+
+    bool active(int action) const {
+        return ((held | pressed) >> action) & 1u;
+    }
+
+    bool wasPressed(int action) const {
+        return (pressed >> action) & 1u;
+    }
+};
+
+// Collects GLFW input as timestamped events and turns them into actions per fixed tick.
+// GLFW has no gamepad callbacks, so pollGamepads() compares the gamepad state once per frame and
+// queues the differences as the same kind of events.
+class InputSystem {
+public:
+    static constexpr float AXIS_THRESHOLD = 0.5f;
+
+private:
+    const Clock& clock;
+    InputEventQueue queue;
+    ActionMap map;
+    uint8_t bindingsDown[ActionMap::MAX_ACTIONS] = {}; // several inputs can hold one action
+    uint32_t held = 0;
+    glm::vec2 cursorPosition{ 0.0f };
+    glm::vec2 scrollOffset{ 0.0f };
+    GLFWgamepadstate gamepad = {};
+
+public:
+    InputSystem(const Clock& clock) : clock(clock) {}
+    InputSystem(const InputSystem&) = delete;
+    InputSystem& operator=(const InputSystem&) = delete;
+
+    // Takes over the window's user pointer and input callbacks
+    void attach(GLFWwindow* window) {
+        glfwSetWindowUserPointer(window, this);
+        glfwSetKeyCallback(window, [](GLFWwindow* w, int key, int, int action, int) {
+            if (action != GLFW_REPEAT)
+                self(w).push(InputDevice::Key, key, action == GLFW_PRESS);
+        });
+        glfwSetCharCallback(window, [](GLFWwindow* w, unsigned int codepoint) {
+            self(w).push(InputDevice::Char, int32_t(codepoint), true);
+        });
+        glfwSetMouseButtonCallback(window, [](GLFWwindow* w, int button, int action, int) {
+            self(w).push(InputDevice::MouseButton, button, action == GLFW_PRESS);
+        });
+        glfwSetCursorPosCallback(window, [](GLFWwindow* w, double x, double y) {
+            self(w).push(InputDevice::CursorMove, 0, false, glm::vec2(float(x), float(y)));
+        });
+        glfwSetScrollCallback(window, [](GLFWwindow* w, double x, double y) {
+            self(w).push(InputDevice::Scroll, 0, false, glm::vec2(float(x), float(y)));
+        });
+    }
+
+    ActionMap& actions() {
+        return map;
+    }
+
+    // Call on the callback thread after polling events
+    void pollGamepads() {
+        GLFWgamepadstate state = {};
+        if (!glfwJoystickIsGamepad(GLFW_JOYSTICK_1) || !glfwGetGamepadState(GLFW_JOYSTICK_1, &state))
+            state = {}; // disconnecting releases everything
+        for (int button = 0; button <= GLFW_GAMEPAD_BUTTON_LAST; button++)
+            if (state.buttons[button] != gamepad.buttons[button])
+                push(InputDevice::GamepadButton, button, state.buttons[button] == GLFW_PRESS);
+        for (int axis = 0; axis <= GLFW_GAMEPAD_AXIS_LAST; axis++)
+            for (int positive = 0; positive < 2; positive++)
+            {
+                float sign = positive ? 1.0f : -1.0f;
+                bool down = state.axes[axis] * sign > AXIS_THRESHOLD;
+                if (down != (gamepad.axes[axis] * sign > AXIS_THRESHOLD))
+                    push(InputDevice::GamepadAxis, axis * 2 + positive, down);
+            }
+        gamepad = state;
+    }
+
+    // Applies every event that arrived up to `until` and returns the actions of that tick.
+    // Later events stay queued for the tick they belong to.
+    ActionFrame consumeUntil(double until) {
+        ActionFrame frame;
+        while (const InputEvent* event = queue.peek())
+        {
+            if (event->time > until)
+                break;
+            apply(*event, frame);
+            queue.pop();
+        }
+        frame.held = held;
+        return frame;
+    }
+
+    glm::vec2 cursor() const {
+        return cursorPosition;
+    }
+
+    // scroll accumulated since the last call
+    glm::vec2 takeScroll() {
+        glm::vec2 offset = scrollOffset;
+        scrollOffset = glm::vec2(0.0f);
+        return offset;
+    }
+
+    uint64_t droppedEvents() const {
+        return queue.dropped();
+    }
+
+private:
+    static InputSystem& self(GLFWwindow* window) {
+        return *static_cast<InputSystem*>(glfwGetWindowUserPointer(window));
+    }
+
+    void push(InputDevice device, int32_t code, bool down, glm::vec2 value = glm::vec2(0.0f)) {
+        queue.push({ clock.seconds(), device, down, code, value });
+    }
+
+    void apply(const InputEvent& event, ActionFrame& frame) {
+        if (event.device == InputDevice::CursorMove)
+        {
+            cursorPosition = event.value;
+            return;
+        }
+        if (event.device == InputDevice::Scroll)
+        {
+            scrollOffset += event.value;
+            return;
+        }
+        int action = map.action(event.device, event.code);
+        if (action == ActionMap::UNBOUND)
+            return;
+        uint32_t bit = 1u << action;
+        if (event.down)
+        {
+            if (bindingsDown[action]++ == 0)
+            {
+                held |= bit;
+                frame.pressed |= bit;
+            }
+        }
+        else if (bindingsDown[action] > 0 && --bindingsDown[action] == 0)
+        {
+            held &= ~bit;
+            frame.released |= bit;
+        }
+    }
+};
@@ -0,0 +1,165 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <iostream>
+
+#include "Core/TickInput.hpp"
+
+// Binary input trace, little endian:
+//   header   "INPR", version, tick rate, tick count, event count, state hash after the last tick
+//   events   varint tick delta since the previous event, varint buttons
+// An event is only stored when the input differs from the tick before, so a held key costs nothing.
+struct InputRecordingHeader {
+    char magic[4];
+    uint32_t version;
+    double tickRate;
+    uint64_t tickCount;
+    uint64_t eventCount;
+    uint64_t stateHash;
+};
+
+namespace InputRecordingDetail {
+
+    inline void writeVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80)
+        {
+            out.push_back(uint8_t(value) | 0x80);
+            value >>= 7;
+        }
+        out.push_back(uint8_t(value));
+    }
+
+    inline bool readVarint(const std::vector<uint8_t>& in, size_t& offset, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && offset < in.size(); shift += 7)
+        {
+            uint8_t byte = in[offset++];
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+}
+
+// Collects one TickInput per simulated tick and writes the trace when the run ends
+class InputRecorder {
+private:
+    std::vector<uint8_t> events;
+    uint64_t eventCount = 0;
+    uint64_t tickCount = 0;
+    uint64_t lastEventTick = 0;
+    TickInput last;
+
+public:
+    void record(const TickInput& input) {
+        if (input != last)
+        {
+            InputRecordingDetail::writeVarint(events, tickCount - lastEventTick);
+            InputRecordingDetail::writeVarint(events, input.buttons);
+            lastEventTick = tickCount;
+            last = input;
+            eventCount++;
+        }
+        tickCount++;
+    }
+
+    uint64_t ticks() const {
+        return tickCount;
+    }
+
+    // stateHash identifies the world after the last recorded tick, a replay has to reproduce it
+    bool save(const std::string& filepath, double tickRate, uint64_t stateHash) const {
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file)
+        {
+            std::cout << "INPUT::Failed to open " << filepath << " for writing" << "\n";
+            return false;
+        }
+        InputRecordingHeader header = {};
+        std::memcpy(header.magic, "INPR", 4);
+        header.version = 1;
+        header.tickRate = tickRate;
+        header.tickCount = tickCount;
+        header.eventCount = eventCount;
+        header.stateHash = stateHash;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(events.data()), std::streamsize(events.size()));
+        std::cout << "Recorded " << tickCount << " ticks (" << eventCount << " input changes, "
+                  << sizeof(header) + events.size() << " bytes) to " << filepath << "\n";
+        return bool(file);
+    }
+};
+
+// Plays a trace back one tick at a time
+class InputReplay {
+private:
+    InputRecordingHeader header = {};
+    std::vector<uint8_t> events;
+    size_t offset = 0;
+    uint64_t tick = 0;
+    uint64_t nextEventTick = 0;
+    uint32_t nextButtons = 0;
+    bool hasNext = false;
+    TickInput current;
+
+public:
+    bool load(const std::string& filepath) {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, "INPR", 4) != 0 || header.version != 1)
+        {
+            std::cout << "INPUT::" << filepath << " is not an input recording" << "\n";
+            return false;
+        }
+        events.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        rewind();
+        return true;
+    }
+
+    void rewind() {
+        offset = 0;
+        tick = 0;
+        nextEventTick = 0;
+        current = TickInput();
+        readEvent();
+    }
+
+    bool finished() const {
+        return tick >= header.tickCount;
+    }
+
+    // input for the next tick
+    TickInput next() {
+        while (hasNext && nextEventTick <= tick)
+        {
+            current.buttons = nextButtons;
+            readEvent();
+        }
+        tick++;
+        return current;
+    }
+
+    double tickRate() const {
+        return header.tickRate;
+    }
+
+    uint64_t tickCount() const {
+        return header.tickCount;
+    }
+
+    uint64_t expectedStateHash() const {
+        return header.stateHash;
+    }
+
+private:
+    void readEvent() {
+        uint64_t delta = 0, buttons = 0;
+        hasNext = InputRecordingDetail::readVarint(events, offset, delta) && InputRecordingDetail::readVarint(events, offset, buttons);
+        nextEventTick += delta;
+        nextButtons = uint32_t(buttons);
+    }
+};
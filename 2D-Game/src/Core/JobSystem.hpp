@@ -0,0 +1,266 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+#include "Core/Profiler.hpp"
+
+// Counts outstanding jobs. A job started with a counter decrements it when it finishes,
+// so a parent waits on all its children with a single JobSystem::wait.
+struct JobCounter {
+    std::atomic<int> pending{ 0 };
+
+    bool done() const {
+        return pending.load(std::memory_order_acquire) == 0;
+    }
+};
+
+struct Job {
+    std::function<void()> work;
+    JobCounter* counter;
+};
+
+// Chase-Lev work-stealing deque (Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models").
+// The owner pushes and pops at the bottom, any other thread steals from the top.
+// Fixed capacity: push fails when full and the caller runs the job inline instead.
+class WorkStealingDeque {
+private:
+    static constexpr int64_t CAPACITY = 4096;
+    static constexpr int64_t MASK = CAPACITY - 1;
+
+    alignas(64) std::atomic<int64_t> top{ 0 };
+    alignas(64) std::atomic<int64_t> bottom{ 0 };
+    std::unique_ptr<std::atomic<Job*>[]> buffer{ new std::atomic<Job*>[CAPACITY] };
+
+public:
+    bool push(Job* job) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= CAPACITY)
+            return false;
+        buffer[b & MASK].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    Job* pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b)
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        Job* job = buffer[b & MASK].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // last item, race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    Job* steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+        Job* job = buffer[t & MASK].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return job;
+    }
+};
+
+// Work-stealing job system. The thread that constructs it is worker 0 and only runs jobs while
+// it waits; the other workers are background threads. Threads that are not workers (e.g. the
+// render thread) submit through a locked injection queue and also help while they wait.
+// A thread is a worker of one system at a time. A system built on a thread that already works
+// for another (a bench's temporary pool) takes it over and hands it back when destroyed, so
+// systems on one thread have to be destroyed in reverse order of construction.
+class JobSystem {
+private:
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+    std::vector<std::thread> threads;
+    std::deque<Job*> injected;
+    std::mutex injectedMutex;
+    std::atomic<int> injectedCount{ 0 };
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> queued{ 0 };
+    std::atomic<bool> stopping{ false };
+
+    struct WorkerSlot {
+        const JobSystem* owner = nullptr;
+        int index = -1;
+    };
+
+    WorkerSlot constructingThread; // what the constructing thread was before, restored on destruction
+
+    static WorkerSlot& workerSlot() {
+        thread_local WorkerSlot slot;
+        return slot;
+    }
+
+    // the calling thread's deque in this system, -1 when it is not one of its workers
+    int workerIndex() const {
+        const WorkerSlot& slot = workerSlot();
+        return slot.owner == this ? slot.index : -1;
+    }
+
+public:
+    JobSystem(unsigned threadCount = std::max(1u, std::thread::hardware_concurrency())) {
+        threadCount = std::max(1u, threadCount);
+        for (unsigned i = 0; i < threadCount; i++)
+            deques.push_back(std::make_unique<WorkStealingDeque>());
+        constructingThread = workerSlot();
+        workerSlot() = { this, 0 };
+        for (unsigned i = 1; i < threadCount; i++)
+            threads.emplace_back([this, i]() { workerLoop(int(i)); });
+    }
+
+    ~JobSystem() {
+        stopping = true;
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wake.notify_all();
+        for (std::thread& thread : threads)
+            thread.join();
+        if (workerSlot().owner == this)
+            workerSlot() = constructingThread;
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned workerCount() const {
+        return unsigned(deques.size());
+    }
+
+    // index of the calling thread in the system it works for, -1 on threads that are not workers
+    static int currentWorker() {
+        return workerSlot().index;
+    }
+
+    void run(std::function<void()> work, JobCounter& counter) {
+        counter.pending.fetch_add(1, std::memory_order_relaxed);
+        Job* job = new Job{ std::move(work), &counter };
+        int index = workerIndex();
+        if (index >= 0 && index < int(deques.size()))
+        {
+            if (!deques[index]->push(job))
+            {
+                execute(job);
+                return;
+            }
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(injectedMutex);
+            injected.push_back(job);
+            injectedCount.fetch_add(1, std::memory_order_release);
+        }
+        queued.fetch_add(1, std::memory_order_release);
+        wake.notify_one();
+    }
+
+    // Runs other jobs until the counter drains, so waiting never idles a core
+    void wait(const JobCounter& counter) {
+        while (!counter.done())
+        {
+            if (Job* job = findJob(workerIndex()))
+                execute(job);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    // Calls body(first, last) over [begin, end) in chunks of at most grain, then waits. The chunks
+    // start at begin + k * grain whatever the worker count, so bodies may keep scratch per chunk.
+    template<typename Body>
+    void parallelFor(size_t begin, size_t end, size_t grain, const Body& body) {
+        grain = std::max<size_t>(grain, 1);
+        if (end - begin <= grain || deques.size() == 1)
+        {
+            for (size_t first = begin; first < end; first += grain)
+                body(first, std::min(first + grain, end));
+            return;
+        }
+        JobCounter counter;
+        // keep the first chunk for this thread, it would only wait otherwise
+        for (size_t first = begin + grain; first < end; first += grain)
+        {
+            size_t last = std::min(first + grain, end);
+            run([&body, first, last]() { body(first, last); }, counter);
+        }
+        body(begin, std::min(begin + grain, end));
+        wait(counter);
+    }
+
+private:
+    void execute(Job* job) {
+        {
+            PROFILE_SCOPE("Job");
+            job->work();
+        }
+        job->counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+        delete job;
+    }
+
+    Job* findJob(int self) {
+        Job* job = nullptr;
+        if (self >= 0 && self < int(deques.size()))
+            job = deques[self]->pop();
+        if (!job && injectedCount.load(std::memory_order_acquire) > 0)
+        {
+            std::lock_guard<std::mutex> lock(injectedMutex);
+            if (!injected.empty())
+            {
+                job = injected.front();
+                injected.pop_front();
+                injectedCount.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        // steal starting after ourselves so thieves spread over the victims
+        int count = int(deques.size());
+        for (int i = 1; !job && i <= count; i++)
+            job = deques[(self + i + count) % count]->steal();
+        if (job)
+            queued.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    void workerLoop(int index) {
+        workerSlot() = { this, index };
+        PROFILE_THREAD("Worker");
+        while (!stopping.load(std::memory_order_relaxed))
+        {
+            if (Job* job = findJob(index))
+            {
+                execute(job);
+                continue;
+            }
+            // idle: sleep until something is queued, the timeout covers a missed notify
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wake.wait_for(lock, std::chrono::milliseconds(1), [this]() {
+                return stopping.load(std::memory_order_relaxed) || queued.load(std::memory_order_acquire) > 0;
+            });
+        }
+    }
+};
@@ -0,0 +1,150 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// LZ4 block format (no frame, no checksums), compatible with the reference decoder.
+// A block is a run of sequences: a token (literal length << 4 | match length - 4), extra length
+// bytes of 255 for either length when its nibble is 15, the literals, then a little endian 16 bit
+// match offset. The last sequence is literals only and covers at least the last 5 bytes.
+// The compressor is the plain greedy single-probe one: fast, and on tile data (long runs of the
+// same few frames) it gets most of what the high-compression modes would.
+namespace Lz4Detail {
+
+    constexpr int MIN_MATCH = 4;
+    constexpr size_t LAST_LITERALS = 5;  // the block ends with at least this many literals
+    constexpr size_t MATCH_LIMIT = 12;   // no match starts within this many bytes of the end
+    constexpr int HASH_BITS = 12;
+    constexpr size_t MAX_OFFSET = 65535;
+
+    inline uint32_t read32(const uint8_t* p) {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t hash(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    inline uint8_t* writeLength(uint8_t* out, size_t length) {
+        for (; length >= 255; length -= 255)
+            *out++ = 255;
+        *out++ = uint8_t(length);
+        return out;
+    }
+
+    inline uint8_t* writeSequence(uint8_t* out, const uint8_t* literals, size_t literalLength, size_t offset, size_t matchLength) {
+        uint8_t* token = out++;
+        *token = uint8_t((literalLength >= 15 ? 15 : literalLength) << 4);
+        if (literalLength >= 15)
+            out = writeLength(out, literalLength - 15);
+        std::memcpy(out, literals, literalLength);
+        out += literalLength;
+        if (matchLength == 0)
+            return out;
+        *out++ = uint8_t(offset);
+        *out++ = uint8_t(offset >> 8);
+        matchLength -= MIN_MATCH;
+        *token |= uint8_t(matchLength >= 15 ? 15 : matchLength);
+        if (matchLength >= 15)
+            out = writeLength(out, matchLength - 15);
+        return out;
+    }
+}
+
+namespace Lz4 {
+
+    inline size_t compressBound(size_t size) {
+        return size + size / 255 + 16;
+    }
+
+    // Returns the compressed size, 0 if capacity is below compressBound(size)
+    inline size_t compress(const uint8_t* src, size_t size, uint8_t* dst, size_t capacity) {
+        if (capacity < compressBound(size))
+            return 0;
+        uint8_t* out = dst;
+        size_t anchor = 0;
+        if (size > Lz4Detail::MATCH_LIMIT)
+        {
+            uint32_t table[1 << Lz4Detail::HASH_BITS] = {};
+            size_t limit = size - Lz4Detail::MATCH_LIMIT;
+            size_t ip = 0;
+            while (ip < limit)
+            {
+                uint32_t sequence = Lz4Detail::read32(src + ip);
+                uint32_t h = Lz4Detail::hash(sequence);
+                size_t candidate = table[h];
+                table[h] = uint32_t(ip);
+                if (candidate >= ip || ip - candidate > Lz4Detail::MAX_OFFSET || Lz4Detail::read32(src + candidate) != sequence)
+                {
+                    ip++;
+                    continue;
+                }
+                size_t length = Lz4Detail::MIN_MATCH;
+                while (ip + length < size - Lz4Detail::LAST_LITERALS && src[candidate + length] == src[ip + length])
+                    length++;
+                out = Lz4Detail::writeSequence(out, src + anchor, ip - anchor, ip - candidate, length);
+                ip += length;
+                anchor = ip;
+                if (ip - 2 < limit)
+                    table[Lz4Detail::hash(Lz4Detail::read32(src + ip - 2))] = uint32_t(ip - 2);
+            }
+        }
+        out = Lz4Detail::writeSequence(out, src + anchor, size - anchor, 0, 0);
+        return size_t(out - dst);
+    }
+
+    // Decodes exactly dstSize bytes; false on any malformed or truncated input, never reading or
+    // writing out of bounds
+    inline bool decompress(const uint8_t* src, size_t size, uint8_t* dst, size_t dstSize) {
+        size_t ip = 0, op = 0;
+        auto readLength = [&](size_t& length) {
+            uint8_t extra;
+            do
+            {
+                if (ip >= size)
+                    return false;
+                extra = src[ip++];
+                length += extra;
+            } while (extra == 255);
+            return true;
+        };
+        while (ip < size)
+        {
+            uint8_t token = src[ip++];
+            size_t literalLength = token >> 4;
+            if (literalLength == 15 && !readLength(literalLength))
+                return false;
+            if (literalLength > size - ip || literalLength > dstSize - op)
+                return false;
+            std::memcpy(dst + op, src + ip, literalLength);
+            ip += literalLength;
+            op += literalLength;
+            if (ip == size)
+                break;
+
+            if (size - ip < 2)
+                return false;
+            size_t offset = size_t(src[ip]) | size_t(src[ip + 1]) << 8;
+            ip += 2;
+            if (offset == 0 || offset > op)
+                return false;
+            size_t matchLength = token & 15;
+            if (matchLength == 15 && !readLength(matchLength))
+                return false;
+            matchLength += Lz4Detail::MIN_MATCH;
+            if (matchLength > dstSize - op)
+                return false;
+            // the match may overlap what it writes, a run of one byte is offset 1
+            const uint8_t* match = dst + op - offset;
+            if (offset >= matchLength)
+                std::memcpy(dst + op, match, matchLength);
+            else
+                for (size_t i = 0; i < matchLength; i++)
+                    dst[op + i] = match[i];
+            op += matchLength;
+        }
+        return op == dstSize;
+    }
+}
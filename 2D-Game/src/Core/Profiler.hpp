@@ -0,0 +1,212 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <iostream>
+
+// Build with PROFILING=0 to compile every PROFILE_* macro away
+#ifndef PROFILING
+#define PROFILING 1
+#endif
+
+// Hierarchical CPU profiler. Each thread appends finished scopes to its own ring buffer without
+// locks; exportChromeTrace() writes everything still in the rings as a chrome://tracing JSON file.
+// A thread's ring goes back to the registry when the thread exits and the next new thread takes
+// it over, so there are only ever as many rings as threads alive at once.
+namespace Profiler {
+
+    struct Event {
+        const char* name; // must be a string literal or otherwise outlive the capture
+        int64_t start;    // nanoseconds since the profiler epoch
+        int64_t end;
+    };
+
+    // Single writer ring of events, one per thread plus extra ones such as the GPU timeline.
+    // Every slot carries the number of the event it holds, zero while it is being rewritten, so a
+    // reader copying a slot checks the number before and after and drops the copy if it moved.
+    class Track {
+    private:
+        struct Slot {
+            std::atomic<uint64_t> sequence{ 0 }; // index + 1 of the event held, 0 while it is written
+            std::atomic<const char*> name{ nullptr };
+            std::atomic<int64_t> start{ 0 };
+            std::atomic<int64_t> end{ 0 };
+        };
+
+        std::unique_ptr<Slot[]> slots{ new Slot[CAPACITY] };
+
+    public:
+        static constexpr uint64_t CAPACITY = 1 << 16;
+
+        std::string name;
+        uint32_t id;
+        std::atomic<uint64_t> written{ 0 };
+
+        Track(std::string name, uint32_t id) : name(std::move(name)), id(id) {}
+
+        void record(const char* eventName, int64_t start, int64_t end) {
+            uint64_t index = written.load(std::memory_order_relaxed);
+            Slot& slot = slots[index & (CAPACITY - 1)];
+            slot.sequence.store(0, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.name.store(eventName, std::memory_order_relaxed);
+            slot.start.store(start, std::memory_order_relaxed);
+            slot.end.store(end, std::memory_order_relaxed);
+            slot.sequence.store(index + 1, std::memory_order_release);
+            written.store(index + 1, std::memory_order_release);
+        }
+
+        // Copies event index if the slot still holds it; false once the writer has moved past it
+        bool read(uint64_t index, Event& event) const {
+            const Slot& slot = slots[index & (CAPACITY - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != index + 1)
+                return false;
+            event.name = slot.name.load(std::memory_order_relaxed);
+            event.start = slot.start.load(std::memory_order_relaxed);
+            event.end = slot.end.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return slot.sequence.load(std::memory_order_relaxed) == index + 1;
+        }
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Track>> tracks;
+        std::vector<Track*> released; // tracks of exited threads, kept for the export until reused
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    };
+
+    inline Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    inline int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - registry().epoch).count();
+    }
+
+    // A released track when there is one, it keeps its events until the new owner overwrites them
+    inline Track* createTrack(const std::string& name) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (!r.released.empty())
+        {
+            Track* track = r.released.back();
+            r.released.pop_back();
+            track->name = name;
+            return track;
+        }
+        r.tracks.push_back(std::make_unique<Track>(name, uint32_t(r.tracks.size())));
+        return r.tracks.back().get();
+    }
+
+    // The owner must not record into it afterwards
+    inline void releaseTrack(Track* track) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.released.push_back(track);
+    }
+
+    // holds a thread's track for as long as the thread runs
+    class ThreadTrack {
+    public:
+        Track* track = createTrack("Thread");
+
+        ThreadTrack() = default;
+        ~ThreadTrack() {
+            releaseTrack(track);
+        }
+
+        ThreadTrack(const ThreadTrack&) = delete;
+        ThreadTrack& operator=(const ThreadTrack&) = delete;
+    };
+
+    inline Track& threadTrack() {
+        thread_local ThreadTrack owner;
+        return *owner.track;
+    }
+
+    // Call at the top of a thread, before its first scope is recorded
+    inline void setThreadName(const char* name) {
+        Track& track = threadTrack();
+        std::lock_guard<std::mutex> lock(registry().mutex);
+        track.name = name;
+    }
+
+    class Scope {
+    private:
+        const char* name;
+        int64_t start;
+
+    public:
+        Scope(const char* name) : name(name), start(now()) {}
+        ~Scope() {
+            threadTrack().record(name, start, now());
+        }
+    };
+
+    inline void writeEscaped(std::ofstream& file, const std::string& text) {
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                file << '\\';
+            file << c;
+        }
+    }
+
+    // Writes every event still held by the rings. Safe to call while other threads keep recording:
+    // an event whose slot is overwritten while it is copied is left out rather than written torn.
+    inline bool exportChromeTrace(const std::string& filepath) {
+        std::ofstream file(filepath);
+        if (!file)
+        {
+            std::cout << "PROFILER::Failed to open " << filepath << " for writing" << "\n";
+            return false;
+        }
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        size_t eventCount = 0;
+        file << "{\"traceEvents\":[\n";
+        bool first = true;
+        for (const auto& track : r.tracks)
+        {
+            file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << track->id << ",\"args\":{\"name\":\"";
+            writeEscaped(file, track->name);
+            file << "\"}}";
+            first = false;
+
+            uint64_t written = track->written.load(std::memory_order_acquire);
+            uint64_t begin = written > Track::CAPACITY ? written - Track::CAPACITY : 0;
+            for (uint64_t i = begin; i < written; i++)
+            {
+                Event event;
+                if (!track->read(i, event))
+                    continue;
+                file << ",\n{\"name\":\"";
+                writeEscaped(file, event.name);
+                file << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << track->id
+                     << ",\"ts\":" << double(event.start) / 1000.0 << ",\"dur\":" << double(event.end - event.start) / 1000.0 << "}";
+                eventCount++;
+            }
+        }
+        file << "\n]}\n";
+        std::cout << "Profiler: wrote " << eventCount << " events to " << filepath << "\n";
+        return bool(file);
+    }
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#if PROFILING
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_THREAD(name) Profiler::setThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_THREAD(name)
+#endif
@@ -0,0 +1,264 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+#include "Core/Transform.hpp"
+
+// Parent/child transforms. Nodes are addressed by stable ids; their data lives in flat arrays in
+// breadth-first order, so a parent always comes before its children and the children of
+// consecutive nodes are consecutive. That lets update() walk a dirty subtree one level at a time
+// as a contiguous range, touching only the nodes below something that moved.
+// Creating, destroying or reparenting nodes rebuilds the order on the next update().
+class SceneHierarchy {
+public:
+    using NodeId = uint32_t;
+    static constexpr NodeId NONE = UINT32_MAX;
+
+private:
+    static constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+    // by id, only used to rebuild the order
+    struct Links {
+        NodeId parent = NONE;
+        NodeId firstChild = NONE;
+        NodeId nextSibling = NONE;
+        bool alive = false;
+    };
+    std::vector<Links> links;
+    std::vector<uint32_t> indexOf;   // id -> breadth-first index
+    std::vector<NodeId> freeIds;
+    std::vector<NodeId> roots;
+
+    // what the update walk reads per node, packed so a scattered dirty node costs one cache line
+    struct Order {
+        uint32_t parent;      // NO_INDEX for roots
+        uint32_t firstChild;  // children are [firstChild, firstChild + childCount)
+        uint32_t childCount;
+        uint32_t stamp;       // update pass that last wrote the world matrix
+    };
+
+    // by breadth-first index
+    std::vector<NodeId> ids;
+    std::vector<Order> order;
+    std::vector<Transform> locals;
+    std::vector<glm::mat4> worlds;
+
+    std::vector<uint32_t> dirty;       // indices whose local transform changed
+    std::vector<Transform> pendingLocals; // by id, locals of nodes created since the last rebuild
+    bool structureChanged = false;
+    uint32_t pass = 0;
+    size_t updatedLastPass = 0;
+
+public:
+    NodeId create(NodeId parent = NONE, const Transform& local = Transform()) {
+        NodeId id;
+        if (!freeIds.empty())
+        {
+            id = freeIds.back();
+            freeIds.pop_back();
+        }
+        else
+        {
+            id = NodeId(links.size());
+            links.push_back(Links());
+            indexOf.push_back(NO_INDEX);
+            pendingLocals.push_back(Transform());
+        }
+        links[id] = Links();
+        links[id].alive = true;
+        pendingLocals[id] = local;
+        indexOf[id] = NO_INDEX;
+        attach(id, parent);
+        structureChanged = true;
+        return id;
+    }
+
+    // Destroys the node and everything below it
+    void destroy(NodeId id) {
+        if (!alive(id))
+            return;
+        detach(id);
+        std::vector<NodeId> stack = { id };
+        while (!stack.empty())
+        {
+            NodeId node = stack.back();
+            stack.pop_back();
+            for (NodeId child = links[node].firstChild; child != NONE; child = links[child].nextSibling)
+                stack.push_back(child);
+            links[node] = Links();
+            freeIds.push_back(node);
+        }
+        structureChanged = true;
+    }
+
+    void setParent(NodeId id, NodeId parent) {
+        if (!alive(id) || links[id].parent == parent)
+            return;
+        // refuse to create a cycle
+        for (NodeId p = parent; p != NONE; p = links[p].parent)
+            if (p == id)
+                return;
+        detach(id);
+        attach(id, parent);
+        structureChanged = true;
+    }
+
+    bool alive(NodeId id) const {
+        return id < links.size() && links[id].alive;
+    }
+
+    NodeId parent(NodeId id) const {
+        return links[id].parent;
+    }
+
+    const Transform& local(NodeId id) const {
+        return indexOf[id] == NO_INDEX ? pendingLocals[id] : locals[indexOf[id]];
+    }
+
+    void setLocal(NodeId id, const Transform& transform) {
+        if (indexOf[id] == NO_INDEX)
+        {
+            pendingLocals[id] = transform;
+            return;
+        }
+        locals[indexOf[id]] = transform;
+        dirty.push_back(indexOf[id]);
+    }
+
+    // Valid after update()
+    const glm::mat4& world(NodeId id) const {
+        return worlds[indexOf[id]];
+    }
+
+    // Recomputes the world matrices below every changed node
+    void update() {
+        pass++;
+        if (structureChanged)
+        {
+            rebuild();
+            updatedLastPass = 0;
+            if (!ids.empty())
+                updateRange(0, uint32_t(ids.size() - 1));
+            dirty.clear();
+            structureChanged = false;
+            return;
+        }
+        // ascending order means an ancestor is always handled before its descendants, which are
+        // then stamped and skipped
+        std::sort(dirty.begin(), dirty.end());
+        updatedLastPass = 0;
+        for (uint32_t root : dirty)
+        {
+            if (order[root].stamp == pass)
+                continue;
+            uint32_t first = root, last = root;
+            while (true)
+            {
+                updateRange(first, last);
+                uint32_t nextFirst = order[first].firstChild;
+                uint32_t nextEnd = order[last].firstChild + order[last].childCount;
+                if (nextFirst >= nextEnd)
+                    break;
+                first = nextFirst;
+                last = nextEnd - 1;
+            }
+        }
+        dirty.clear();
+    }
+
+    // Recomputes every world matrix, the baseline the dirty update is measured against
+    void updateAll() {
+        pass++;
+        if (structureChanged)
+        {
+            rebuild();
+            structureChanged = false;
+        }
+        updatedLastPass = 0;
+        if (!ids.empty())
+            updateRange(0, uint32_t(ids.size() - 1));
+        dirty.clear();
+    }
+
+    size_t size() const {
+        return links.size() - freeIds.size();
+    }
+
+    // world matrices written by the last update
+    size_t updatedCount() const {
+        return updatedLastPass;
+    }
+
+private:
+    void updateRange(uint32_t first, uint32_t last) {
+        for (uint32_t i = first; i <= last; i++)
+        {
+            glm::mat4 local = locals[i].to_mat4();
+            worlds[i] = order[i].parent == NO_INDEX ? local : worlds[order[i].parent] * local;
+            order[i].stamp = pass;
+        }
+        updatedLastPass += last - first + 1;
+    }
+
+    void attach(NodeId id, NodeId parent) {
+        links[id].parent = alive(parent) ? parent : NONE;
+        if (links[id].parent == NONE)
+        {
+            roots.push_back(id);
+            return;
+        }
+        links[id].nextSibling = links[parent].firstChild;
+        links[parent].firstChild = id;
+    }
+
+    void detach(NodeId id) {
+        NodeId parent = links[id].parent;
+        if (parent == NONE)
+        {
+            roots.erase(std::find(roots.begin(), roots.end(), id));
+            return;
+        }
+        NodeId* link = &links[parent].firstChild;
+        while (*link != id)
+            link = &links[*link].nextSibling;
+        *link = links[id].nextSibling;
+        links[id].nextSibling = NONE;
+        links[id].parent = NONE;
+    }
+
+    void rebuild() {
+        // carry every local transform over by id before the arrays are reordered
+        for (uint32_t i = 0; i < ids.size(); i++)
+            if (links[ids[i]].alive && indexOf[ids[i]] == i)
+                pendingLocals[ids[i]] = locals[i];
+
+        size_t count = size();
+        ids.clear();
+        ids.reserve(count);
+        ids.insert(ids.end(), roots.begin(), roots.end());
+        order.clear();
+        order.reserve(count);
+        for (size_t i = 0; i < roots.size(); i++)
+            order.push_back({ NO_INDEX, 0, 0, 0 });
+        std::fill(indexOf.begin(), indexOf.end(), NO_INDEX);
+        for (uint32_t i = 0; i < ids.size(); i++)
+        {
+            NodeId id = ids[i];
+            indexOf[id] = i;
+            order[i].firstChild = uint32_t(ids.size());
+            for (NodeId child = links[id].firstChild; child != NONE; child = links[child].nextSibling)
+            {
+                ids.push_back(child);
+                order.push_back({ i, 0, 0, 0 });
+                order[i].childCount++;
+            }
+        }
+        locals.resize(ids.size());
+        for (uint32_t i = 0; i < ids.size(); i++)
+            locals[i] = pendingLocals[ids[i]];
+        worlds.resize(ids.size());
+    }
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <immintrin.h>
+#define SIMD_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#else
+#define SIMD_PREFETCH(address) ((void)(address))
+#endif
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+// Lane types for kernels written once as templates over L: Scalar runs them one element at a time
+// on any target, Float8 eight at a time with AVX2. Only what the physics kernels need is here.
+// A kernel loads with L::load, compares into L::Mask, blends with select() and turns the mask
+// into one bit per lane with bits().
+// Float8 only exists in files built with AVX2, which the rest of the program calls into after
+// checking hasAvx2(); the program as a whole runs on any x64 CPU.
+namespace Simd {
+
+    // The CPU has AVX2 and the OS saves the YMM registers across context switches
+    inline bool hasAvx2() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+            return false;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    }
+
+    struct Scalar {
+        static constexpr int WIDTH = 1;
+        using Mask = bool;
+
+        float v;
+
+        static Scalar set(float x) {
+            return { x };
+        }
+
+        static Scalar load(const float* p) {
+            return { *p };
+        }
+
+        void store(float* p) const {
+            *p = v;
+        }
+    };
+
+    inline Scalar operator+(Scalar a, Scalar b) { return { a.v + b.v }; }
+    inline Scalar operator-(Scalar a, Scalar b) { return { a.v - b.v }; }
+    inline Scalar operator*(Scalar a, Scalar b) { return { a.v * b.v }; }
+    inline Scalar operator/(Scalar a, Scalar b) { return { a.v / b.v }; }
+    inline bool operator<(Scalar a, Scalar b) { return a.v < b.v; }
+    inline bool operator<=(Scalar a, Scalar b) { return a.v <= b.v; }
+    inline bool operator>(Scalar a, Scalar b) { return a.v > b.v; }
+    inline bool operator>=(Scalar a, Scalar b) { return a.v >= b.v; }
+    inline Scalar min(Scalar a, Scalar b) { return { std::min(a.v, b.v) }; }
+    inline Scalar max(Scalar a, Scalar b) { return { std::max(a.v, b.v) }; }
+    inline Scalar abs(Scalar a) { return { std::fabs(a.v) }; }
+    inline Scalar sqrt(Scalar a) { return { std::sqrt(a.v) }; }
+    inline Scalar select(bool mask, Scalar a, Scalar b) { return mask ? a : b; }
+    inline int bits(bool mask) { return mask ? 1 : 0; }
+
+#if defined(__AVX2__)
+    struct Float8 {
+        static constexpr int WIDTH = 8;
+
+        struct Mask {
+            __m256 v;
+        };
+
+        __m256 v;
+
+        static Float8 set(float x) {
+            return { _mm256_set1_ps(x) };
+        }
+
+        static Float8 load(const float* p) {
+            return { _mm256_loadu_ps(p) };
+        }
+
+        void store(float* p) const {
+            _mm256_storeu_ps(p, v);
+        }
+    };
+
+    inline Float8 operator+(Float8 a, Float8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+    inline Float8 operator-(Float8 a, Float8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+    inline Float8 operator*(Float8 a, Float8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+    inline Float8 operator/(Float8 a, Float8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+    inline Float8::Mask operator<(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+    inline Float8::Mask operator<=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+    inline Float8::Mask operator>(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+    inline Float8::Mask operator>=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+    inline Float8::Mask operator&(Float8::Mask a, Float8::Mask b) { return { _mm256_and_ps(a.v, b.v) }; }
+    inline Float8 min(Float8 a, Float8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+    inline Float8 max(Float8 a, Float8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+    inline Float8 abs(Float8 a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+    inline Float8 sqrt(Float8 a) { return { _mm256_sqrt_ps(a.v) }; }
+    inline Float8 select(Float8::Mask mask, Float8 a, Float8 b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+    inline int bits(Float8::Mask mask) { return _mm256_movemask_ps(mask.v); }
+#endif
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// Everything the simulation reads from the player for one fixed tick. simulate() only sees input
+// through this, which is what makes a run recordable and replayable.
+struct TickInput {
+    enum Button : uint32_t {
+        MoveUp = 1 << 0,
+        MoveDown = 1 << 1,
+        MoveLeft = 1 << 2,
+        MoveRight = 1 << 3,
+    };
+
+    uint32_t buttons = 0;
+
+    bool held(Button button) const {
+        return (buttons & button) != 0;
+    }
+
+    glm::vec2 move() const {
+        return glm::vec2(float(held(MoveRight)) - float(held(MoveLeft)), float(held(MoveUp)) - float(held(MoveDown)));
+    }
+
+    bool operator==(const TickInput& other) const {
+        return buttons == other.buttons;
+    }
+
+    bool operator!=(const TickInput& other) const {
+        return !(*this == other);
+    }
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+struct Transform
+{
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::vec3 rotation = glm::vec3(0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);
+	glm::mat4 to_mat4() const
+	{
+		glm::mat4 m = glm::translate(glm::mat4(1.0f), position);
+		m *= glm::mat4_cast(glm::quat(rotation));
+		m = glm::scale(m, scale);
+		return m;
+	}
+};
+
+inline Transform interpolate(const Transform& a, const Transform& b, float alpha)
+{
+	Transform t;
+	t.position = glm::mix(a.position, b.position, alpha);
+	t.rotation = glm::mix(a.rotation, b.rotation, alpha);
+	t.scale = glm::mix(a.scale, b.scale, alpha);
+	return t;
+}
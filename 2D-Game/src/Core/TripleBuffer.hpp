@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Single producer / single consumer mailbox. The producer always has a private buffer to fill,
+// the consumer always reads the newest complete one, and neither ever waits on the other:
+// handing a buffer over is one atomic exchange of the middle slot.
+template<typename T>
+class TripleBuffer {
+private:
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t FRESH = 4; // middle slot holds a buffer the consumer has not seen
+
+    T buffers[3];
+    alignas(64) std::atomic<uint8_t> middle{ 1 };
+    alignas(64) uint8_t back = 0;  // producer only
+    alignas(64) uint8_t front = 2; // consumer only
+
+public:
+    // producer: the buffer to fill, keeps whatever was in it last time it was handed back
+    T& write() {
+        return buffers[back];
+    }
+
+    // producer: hand the filled buffer over, get the stale middle one back
+    void publish() {
+        back = middle.exchange(uint8_t(back | FRESH), std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // consumer: swap in the newest published buffer, false if nothing new arrived
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    // consumer: the buffer swapped in by the last update()
+    const T& read() const {
+        return buffers[front];
+    }
+};
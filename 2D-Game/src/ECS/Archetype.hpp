@@ -0,0 +1,203 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdlib>
+#include <utility>
+#include <type_traits>
+#include <typeinfo>
+#include <iostream>
+
+// Entities are an index into the world's records plus a generation, so a handle to a destroyed
+// entity never aliases the one that reuses its slot.
+struct Entity {
+    static constexpr uint32_t INVALID = UINT32_MAX;
+
+    uint32_t index = INVALID;
+    uint32_t generation = 0;
+
+    bool valid() const {
+        return index != INVALID;
+    }
+
+    bool operator==(const Entity& other) const {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!=(const Entity& other) const {
+        return !(*this == other);
+    }
+};
+
+using ComponentId = uint32_t;
+using ComponentMask = uint64_t;
+constexpr ComponentId MAX_COMPONENTS = 64;
+
+struct ComponentInfo {
+    size_t size;
+    size_t align;
+    const char* name;
+};
+
+namespace ComponentRegistry {
+
+    struct Table {
+        ComponentInfo infos[MAX_COMPONENTS];
+        std::atomic<ComponentId> count{ 0 };
+        std::mutex mutex;
+    };
+
+    inline Table& table() {
+        static Table instance;
+        return instance;
+    }
+
+    inline ComponentId add(size_t size, size_t align, const char* name) {
+        Table& t = table();
+        std::lock_guard<std::mutex> lock(t.mutex);
+        ComponentId id = t.count.load(std::memory_order_relaxed);
+        if (id == MAX_COMPONENTS)
+        {
+            std::cout << "ECS::Too many component types, " << name << " does not fit" << "\n";
+            std::abort();
+        }
+        t.infos[id] = { size, align, name };
+        t.count.store(id + 1, std::memory_order_release);
+        return id;
+    }
+
+    inline const ComponentInfo& info(ComponentId id) {
+        return table().infos[id];
+    }
+}
+
+// Components are plain data, rows are moved between chunks with memcpy
+template<typename T>
+ComponentId componentId() {
+    static_assert(std::is_trivially_copyable<T>::value, "ECS components must be trivially copyable");
+    static const ComponentId id = ComponentRegistry::add(sizeof(T), alignof(T), typeid(T).name());
+    return id;
+}
+
+template<typename... Ts>
+ComponentMask componentMask() {
+    return (ComponentMask(0) | ... | (ComponentMask(1) << componentId<Ts>()));
+}
+
+// 16 KB block holding `capacity` rows of one archetype as separate arrays: the entity handles
+// first, then one column per component, so a query walks each column linearly.
+struct Chunk {
+    static constexpr size_t BYTES = 16 * 1024;
+
+    alignas(64) uint8_t data[BYTES];
+    uint32_t count = 0;
+};
+
+// All entities with exactly one component signature. Every chunk but the last is full.
+class Archetype {
+public:
+    ComponentMask mask;
+    std::vector<ComponentId> components; // ascending
+    uint32_t capacity = 0;               // rows per chunk
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    size_t entityCount = 0;
+    Archetype* addEdges[MAX_COMPONENTS] = {};    // archetype with one more component, filled lazily
+    Archetype* removeEdges[MAX_COMPONENTS] = {};
+
+private:
+    uint32_t offsets[MAX_COMPONENTS] = {};
+    std::unique_ptr<Chunk> spare; // last emptied chunk, kept so add/remove churn does not hit the allocator
+
+public:
+    Archetype(ComponentMask mask) : mask(mask) {
+        size_t rowBytes = sizeof(Entity);
+        for (ComponentId id = 0; id < MAX_COMPONENTS; id++)
+            if (mask & (ComponentMask(1) << id))
+            {
+                components.push_back(id);
+                rowBytes += ComponentRegistry::info(id).size;
+            }
+        // shrink until the aligned columns fit
+        for (capacity = uint32_t(Chunk::BYTES / rowBytes); capacity > 1 && !layout(capacity); capacity--) {}
+        layout(capacity);
+    }
+
+    Archetype(const Archetype&) = delete;
+    Archetype& operator=(const Archetype&) = delete;
+
+    bool has(ComponentId id) const {
+        return (mask >> id) & 1;
+    }
+
+    Entity* entities(Chunk& chunk) const {
+        return reinterpret_cast<Entity*>(chunk.data);
+    }
+
+    void* column(Chunk& chunk, ComponentId id) const {
+        return chunk.data + offsets[id];
+    }
+
+    template<typename T>
+    T* column(Chunk& chunk) const {
+        return reinterpret_cast<T*>(chunk.data + offsets[componentId<T>()]);
+    }
+
+    void* element(uint32_t chunk, uint32_t row, ComponentId id) const {
+        return chunks[chunk]->data + offsets[id] + size_t(row) * ComponentRegistry::info(id).size;
+    }
+
+    // Appends an uninitialized row for entity, returns its chunk and row
+    std::pair<uint32_t, uint32_t> allocate(Entity entity) {
+        if (chunks.empty() || chunks.back()->count == capacity)
+            chunks.push_back(spare ? std::move(spare) : std::make_unique<Chunk>());
+        Chunk& chunk = *chunks.back();
+        uint32_t row = chunk.count++;
+        entities(chunk)[row] = entity;
+        entityCount++;
+        return { uint32_t(chunks.size() - 1), row };
+    }
+
+    // Fills the hole with the archetype's last row and returns the entity that moved into it,
+    // or an invalid one when the removed row was the last
+    Entity remove(uint32_t chunkIndex, uint32_t row) {
+        Chunk& last = *chunks.back();
+        uint32_t lastRow = last.count - 1;
+        Entity moved;
+        if (chunkIndex != chunks.size() - 1 || row != lastRow)
+        {
+            Chunk& chunk = *chunks[chunkIndex];
+            moved = entities(last)[lastRow];
+            entities(chunk)[row] = moved;
+            for (ComponentId id : components)
+            {
+                size_t size = ComponentRegistry::info(id).size;
+                std::memcpy(static_cast<uint8_t*>(column(chunk, id)) + row * size, static_cast<uint8_t*>(column(last, id)) + lastRow * size, size);
+            }
+        }
+        last.count--;
+        entityCount--;
+        if (last.count == 0)
+        {
+            spare = std::move(chunks.back());
+            chunks.pop_back();
+        }
+        return moved;
+    }
+
+private:
+    bool layout(uint32_t rows) {
+        size_t offset = sizeof(Entity) * rows;
+        for (ComponentId id : components)
+        {
+            const ComponentInfo& info = ComponentRegistry::info(id);
+            offset = (offset + info.align - 1) / info.align * info.align;
+            offsets[id] = uint32_t(offset);
+            offset += info.size * rows;
+        }
+        return offset <= Chunk::BYTES;
+    }
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+#include "Core/Transform.hpp"
+
+// Transform itself (Core/Transform.hpp) is the position component
+
+// state of the tick before, rendering blends from it to Transform
+struct PreviousTransform {
+    Transform value;
+};
+
+struct Velocity {
+    glm::vec2 value = glm::vec2(0.0f);
+};
+
+// SpriteSheet frame drawn at the entity's transform
+struct Sprite {
+    uint16_t frame = 0;
+};
+
+// box the character controller sweeps, centered on the transform
+struct Collider {
+    glm::vec2 halfExtents = glm::vec2(0.5f);
+};
+
+// tag, moved by the player's TickInput
+struct PlayerControlled {
+    uint8_t unused = 0;
+};
+
+// carried by no entity: stands in the scheduler's masks for the collider index in Main.cpp
+// (colliders, colliderBoxes, colliderOf), which Broadphase writes and PlayerMove reads
+struct ColliderIndex {
+    uint8_t unused = 0;
+};
@@ -0,0 +1,189 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <ostream>
+#include <iomanip>
+#include <cstdint>
+
+#include "ECS/World.hpp"
+#include "Core/Clock.hpp"
+#include "Core/JobSystem.hpp"
+#include "Core/Profiler.hpp"
+
+// Runs systems in parallel where their declared component sets allow it. Two systems conflict when
+// one writes a component the other reads or writes; a conflicting pair keeps registration order,
+// everything else may overlap. The DAG is rebuilt only when systems are added.
+// State kept outside the world is declared the same way, with a tag component no entity carries
+// standing for it, so the systems sharing it are ordered by the same rule.
+// Systems must not make structural changes directly: they get their own CommandBuffer, and the
+// buffers are flushed in registration order after the last system finishes.
+class SystemScheduler {
+public:
+    using SystemFn = std::function<void(World&, CommandBuffer&)>;
+
+private:
+    struct System {
+        const char* name;
+        ComponentMask reads;
+        ComponentMask writes;
+        SystemFn run;
+        CommandBuffer commands;
+
+        std::vector<size_t> dependents;
+        int dependencyCount = 0;
+        int level = 0;                 // longest chain of dependencies before this system
+        std::atomic<int> waiting{ 0 }; // dependencies still running this frame
+
+        int64_t start = 0, end = 0;    // nanoseconds since the run began
+        int worker = -1;
+    };
+
+    std::vector<std::unique_ptr<System>> systems;
+    bool dirty = true;
+    Clock clock;
+    int64_t runStart = 0;
+    double wallSeconds = 0.0;
+
+public:
+    // name must outlive the scheduler, it is also the profiler label
+    void add(const char* name, ComponentMask reads, ComponentMask writes, SystemFn run) {
+        auto system = std::make_unique<System>();
+        system->name = name;
+        system->reads = reads;
+        system->writes = writes;
+        system->run = std::move(run);
+        systems.push_back(std::move(system));
+        dirty = true;
+    }
+
+    // Runs every system once; without a job system they run one after another
+    void run(World& world, JobSystem* jobs) {
+        if (!jobs || jobs->workerCount() == 1)
+        {
+            runSerial(world);
+            return;
+        }
+        build();
+        runStart = clock.nanoseconds();
+        for (const auto& system : systems)
+            system->waiting.store(system->dependencyCount, std::memory_order_relaxed);
+
+        JobCounter counter;
+        for (size_t i = 0; i < systems.size(); i++)
+            if (systems[i]->dependencyCount == 0)
+                launch(i, world, *jobs, counter);
+        jobs->wait(counter);
+        wallSeconds = double(clock.nanoseconds() - runStart) * 1e-9;
+        flush(world);
+    }
+
+    // Registration order on the calling thread, the baseline the parallel schedule is measured against
+    void runSerial(World& world) {
+        build();
+        runStart = clock.nanoseconds();
+        for (size_t i = 0; i < systems.size(); i++)
+            execute(i, world);
+        wallSeconds = double(clock.nanoseconds() - runStart) * 1e-9;
+        flush(world);
+    }
+
+    // wall time of the last run
+    double lastRunSeconds() const {
+        return wallSeconds;
+    }
+
+    // sum of the systems' own times in the last run, what a serial run would at least take
+    double lastWorkSeconds() const {
+        int64_t total = 0;
+        for (const auto& system : systems)
+            total += system->end - system->start;
+        return double(total) * 1e-9;
+    }
+
+    // DAG levels, then the last run as one line per system with its worker and an ASCII timeline
+    void printSchedule(std::ostream& out) {
+        build();
+        int levels = 0;
+        for (const auto& system : systems)
+            levels = std::max(levels, system->level + 1);
+        out << "Schedule: " << systems.size() << " systems in " << levels << " levels" << "\n";
+        for (int level = 0; level < levels; level++)
+        {
+            out << "  level " << level << ":";
+            for (size_t i = 0; i < systems.size(); i++)
+                if (systems[i]->level == level)
+                    out << " " << systems[i]->name;
+            out << "\n";
+        }
+        for (size_t i = 0; i < systems.size(); i++)
+            for (size_t dependent : systems[i]->dependents)
+                out << "  " << systems[i]->name << " -> " << systems[dependent]->name << "\n";
+
+        const int columns = 60;
+        int64_t span = std::max<int64_t>(int64_t(wallSeconds * 1e9), 1);
+        out << "Last run: " << wallSeconds * 1000.0 << " ms wall, " << lastWorkSeconds() * 1000.0 << " ms of system work, "
+            << lastWorkSeconds() / std::max(wallSeconds, 1e-12) << "x overlap" << "\n";
+        for (const auto& system : systems)
+        {
+            int first = int(system->start * columns / span);
+            int last = std::max(first + 1, int(system->end * columns / span));
+            out << "  " << std::left << std::setw(20) << system->name << std::right << " w" << std::setw(2) << system->worker << " |";
+            for (int c = 0; c < columns; c++)
+                out << (c >= first && c < last ? '#' : ' ');
+            out << "| " << double(system->end - system->start) * 1e-6 << " ms" << "\n";
+        }
+    }
+
+private:
+    void build() {
+        if (!dirty)
+            return;
+        for (const auto& system : systems)
+        {
+            system->dependents.clear();
+            system->dependencyCount = 0;
+            system->level = 0;
+        }
+        for (size_t j = 0; j < systems.size(); j++)
+            for (size_t i = 0; i < j; i++)
+            {
+                const System& a = *systems[i];
+                System& b = *systems[j];
+                bool conflict = (a.writes & (b.reads | b.writes)) || (a.reads & b.writes);
+                if (!conflict)
+                    continue;
+                systems[i]->dependents.push_back(j);
+                b.dependencyCount++;
+                b.level = std::max(b.level, a.level + 1); // i < j, so a's level is final
+            }
+        dirty = false;
+    }
+
+    void launch(size_t index, World& world, JobSystem& jobs, JobCounter& counter) {
+        jobs.run([this, index, &world, &jobs, &counter]() {
+            execute(index, world);
+            // the last finished dependency starts the dependent
+            for (size_t dependent : systems[index]->dependents)
+                if (systems[dependent]->waiting.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    launch(dependent, world, jobs, counter);
+        }, counter);
+    }
+
+    void execute(size_t index, World& world) {
+        System& system = *systems[index];
+        PROFILE_SCOPE(system.name);
+        system.worker = JobSystem::currentWorker();
+        system.start = clock.nanoseconds() - runStart;
+        system.run(world, system.commands);
+        system.end = clock.nanoseconds() - runStart;
+    }
+
+    void flush(World& world) {
+        for (const auto& system : systems)
+            if (!system->commands.empty())
+                world.flush(system->commands);
+    }
+};
@@ -0,0 +1,311 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+
+#include "ECS/Archetype.hpp"
+
+class World;
+
+// Structural changes recorded while a query is running and applied later by World::flush.
+// Spawns are applied in one move: every component added right after create() lands in the final
+// archetype directly instead of hopping through one archetype per component.
+class CommandBuffer {
+private:
+    friend class World;
+
+    enum class Op : uint8_t { Create, Destroy, Add, Remove };
+
+    struct Command {
+        Op op;
+        ComponentId component;
+        Entity entity;     // invalid for components of the preceding create()
+        uint32_t offset;   // payload for Add
+    };
+
+    std::vector<Command> commands;
+    std::vector<uint8_t> payload; // component values, copied out with memcpy so no alignment is needed
+
+public:
+    // Components passed here go to the new entity
+    template<typename... Ts>
+    void create(const Ts&... values) {
+        commands.push_back({ Op::Create, 0, Entity(), 0 });
+        (push(Entity(), values), ...);
+    }
+
+    void destroy(Entity entity) {
+        commands.push_back({ Op::Destroy, 0, entity, 0 });
+    }
+
+    template<typename T>
+    void add(Entity entity, const T& value) {
+        push(entity, value);
+    }
+
+    template<typename T>
+    void remove(Entity entity) {
+        commands.push_back({ Op::Remove, componentId<T>(), entity, 0 });
+    }
+
+    bool empty() const {
+        return commands.empty();
+    }
+
+    size_t size() const {
+        return commands.size();
+    }
+
+    void clear() {
+        commands.clear();
+        payload.clear();
+    }
+
+private:
+    template<typename T>
+    void push(Entity entity, const T& value) {
+        uint32_t offset = uint32_t(payload.size());
+        payload.resize(offset + sizeof(T));
+        std::memcpy(payload.data() + offset, &value, sizeof(T));
+        commands.push_back({ Op::Add, componentId<T>(), entity, offset });
+    }
+};
+
+// Owns every entity and archetype. Not thread safe for structural changes; systems that run in
+// parallel read and write components through queries and defer the rest to a CommandBuffer.
+class World {
+private:
+    struct Record {
+        Archetype* archetype = nullptr;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    std::vector<Record> records;
+    std::vector<uint32_t> freeIndices;
+    std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> archetypeByMask;
+    std::vector<Archetype*> archetypes;
+    Archetype* emptyArchetype;
+
+public:
+    World() {
+        emptyArchetype = archetype(0);
+    }
+
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    template<typename... Ts>
+    Entity create(const Ts&... values) {
+        Archetype* target = archetype(componentMask<Ts...>());
+        Entity entity = newEntity();
+        place(entity, target);
+        (std::memcpy(get<Ts>(entity), &values, sizeof(Ts)), ...);
+        return entity;
+    }
+
+    void destroy(Entity entity) {
+        if (!alive(entity))
+            return;
+        Record& record = records[entity.index];
+        unplace(record);
+        record.archetype = nullptr;
+        record.generation++;
+        freeIndices.push_back(entity.index);
+    }
+
+    bool alive(Entity entity) const {
+        return entity.index < records.size() && records[entity.index].generation == entity.generation && records[entity.index].archetype;
+    }
+
+    // Adds the component, or overwrites it when the entity already has one
+    template<typename T>
+    void add(Entity entity, const T& value) {
+        if (!alive(entity))
+            return;
+        ComponentId id = componentId<T>();
+        Record& record = records[entity.index];
+        if (!record.archetype->has(id))
+            move(entity, addEdge(record.archetype, id));
+        std::memcpy(get<T>(entity), &value, sizeof(T));
+    }
+
+    template<typename T>
+    void remove(Entity entity) {
+        ComponentId id = componentId<T>();
+        if (alive(entity) && records[entity.index].archetype->has(id))
+            move(entity, removeEdge(records[entity.index].archetype, id));
+    }
+
+    template<typename T>
+    bool has(Entity entity) const {
+        return alive(entity) && records[entity.index].archetype->has(componentId<T>());
+    }
+
+    // nullptr when the entity is dead or lacks the component. Valid until the next structural change.
+    template<typename T>
+    T* get(Entity entity) {
+        if (!has<T>(entity))
+            return nullptr;
+        const Record& record = records[entity.index];
+        return static_cast<T*>(record.archetype->element(record.chunk, record.row, componentId<T>()));
+    }
+
+    // Calls f(count, entities, columns...) once per chunk holding at least Ts. The columns are
+    // the chunk's SoA arrays, so the body is a plain loop over [0, count).
+    template<typename... Ts, typename F>
+    void forEachChunk(F&& f) {
+        ComponentMask required = componentMask<Ts...>();
+        for (Archetype* a : archetypes)
+        {
+            if ((a->mask & required) != required || a->entityCount == 0)
+                continue;
+            for (const std::unique_ptr<Chunk>& chunk : a->chunks)
+                f(size_t(chunk->count), a->entities(*chunk), a->template column<Ts>(*chunk)...);
+        }
+    }
+
+    // Calls f(components&...) for every entity holding at least Ts
+    template<typename... Ts, typename F>
+    void each(F&& f) {
+        forEachChunk<Ts...>([&f](size_t count, Entity*, Ts*... columns) {
+            for (size_t i = 0; i < count; i++)
+                f(columns[i]...);
+        });
+    }
+
+    // Chunks matching a query, for systems that split the work across jobs
+    template<typename... Ts>
+    void matchingChunks(std::vector<std::pair<Archetype*, Chunk*>>& out) {
+        out.clear();
+        ComponentMask required = componentMask<Ts...>();
+        for (Archetype* a : archetypes)
+            if ((a->mask & required) == required)
+                for (const std::unique_ptr<Chunk>& chunk : a->chunks)
+                    out.push_back({ a, chunk.get() });
+    }
+
+    // Applies and clears the buffer, in recording order
+    void flush(CommandBuffer& buffer) {
+        for (size_t i = 0; i < buffer.commands.size(); i++)
+        {
+            const CommandBuffer::Command& command = buffer.commands[i];
+            switch (command.op)
+            {
+            case CommandBuffer::Op::Create:
+            {
+                // gather the spawn's components so the entity is placed only once
+                size_t end = i + 1;
+                ComponentMask mask = 0;
+                while (end < buffer.commands.size() && buffer.commands[end].op == CommandBuffer::Op::Add && !buffer.commands[end].entity.valid())
+                    mask |= ComponentMask(1) << buffer.commands[end++].component;
+                Entity entity = newEntity();
+                place(entity, archetype(mask));
+                const Record& record = records[entity.index];
+                for (size_t c = i + 1; c < end; c++)
+                {
+                    ComponentId id = buffer.commands[c].component;
+                    std::memcpy(record.archetype->element(record.chunk, record.row, id), buffer.payload.data() + buffer.commands[c].offset, ComponentRegistry::info(id).size);
+                }
+                i = end - 1;
+                break;
+            }
+            case CommandBuffer::Op::Destroy:
+                destroy(command.entity);
+                break;
+            case CommandBuffer::Op::Add:
+            {
+                if (!alive(command.entity))
+                    break;
+                Record& record = records[command.entity.index];
+                if (!record.archetype->has(command.component))
+                    move(command.entity, addEdge(record.archetype, command.component));
+                std::memcpy(record.archetype->element(record.chunk, record.row, command.component), buffer.payload.data() + command.offset, ComponentRegistry::info(command.component).size);
+                break;
+            }
+            case CommandBuffer::Op::Remove:
+                if (alive(command.entity) && records[command.entity.index].archetype->has(command.component))
+                    move(command.entity, removeEdge(records[command.entity.index].archetype, command.component));
+                break;
+            }
+        }
+        buffer.clear();
+    }
+
+    size_t entityCount() const {
+        return records.size() - freeIndices.size();
+    }
+
+    size_t archetypeCount() const {
+        return archetypes.size();
+    }
+
+private:
+    Archetype* archetype(ComponentMask mask) {
+        auto it = archetypeByMask.find(mask);
+        if (it != archetypeByMask.end())
+            return it->second.get();
+        Archetype* created = new Archetype(mask);
+        archetypeByMask.emplace(mask, std::unique_ptr<Archetype>(created));
+        archetypes.push_back(created);
+        return created;
+    }
+
+    Archetype* addEdge(Archetype* from, ComponentId id) {
+        if (!from->addEdges[id])
+            from->addEdges[id] = archetype(from->mask | (ComponentMask(1) << id));
+        return from->addEdges[id];
+    }
+
+    Archetype* removeEdge(Archetype* from, ComponentId id) {
+        if (!from->removeEdges[id])
+            from->removeEdges[id] = archetype(from->mask & ~(ComponentMask(1) << id));
+        return from->removeEdges[id];
+    }
+
+    Entity newEntity() {
+        if (!freeIndices.empty())
+        {
+            uint32_t index = freeIndices.back();
+            freeIndices.pop_back();
+            return { index, records[index].generation };
+        }
+        records.push_back(Record());
+        return { uint32_t(records.size() - 1), 0 };
+    }
+
+    void place(Entity entity, Archetype* target) {
+        Record& record = records[entity.index];
+        auto [chunk, row] = target->allocate(entity);
+        record.archetype = target;
+        record.chunk = chunk;
+        record.row = row;
+    }
+
+    // removes the row and patches the record of the entity swapped into it
+    void unplace(const Record& record) {
+        Entity moved = record.archetype->remove(record.chunk, record.row);
+        if (moved.valid())
+        {
+            records[moved.index].chunk = record.chunk;
+            records[moved.index].row = record.row;
+        }
+    }
+
+    // Moves the entity's row to another archetype, keeping the components both share
+    void move(Entity entity, Archetype* target) {
+        Record old = records[entity.index];
+        auto [chunk, row] = target->allocate(entity);
+        for (ComponentId id : target->components)
+            if (old.archetype->has(id))
+                std::memcpy(target->element(chunk, row, id), old.archetype->element(old.chunk, old.row, id), ComponentRegistry::info(id).size);
+        unplace(old);
+        Record& record = records[entity.index];
+        record.archetype = target;
+        record.chunk = chunk;
+        record.row = row;
+    }
+};
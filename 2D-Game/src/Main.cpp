@@ -7,6 +7,8 @@
 #include <cmath>
 #include <filesystem>
 #include <map>
+#include <thread>
+#include <atomic>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -14,6 +16,39 @@
 
 #include "Render/Shader.hpp"
 #include "Render/Texture.hpp"
+#include "Render/ResourceRegistry.hpp"
+#include "Render/SpriteSheet.hpp"
+#include "Render/TextureAtlas.hpp"
+#include "Render/TextureCompressor.hpp"
+#include "Render/FramePacket.hpp"
+#include "Render/FramePacer.hpp"
+#include "Render/GpuProfiler.hpp"
+#include "Render/PerfOverlay.hpp"
+#include "Render/RenderStats.hpp"
+#include "Render/Tilemap.hpp"
+#include "Render/TilemapRenderer.hpp"
+#include "Render/TilemapFile.hpp"
+#include "Render/TileStreamer.hpp"
+#include "Core/Clock.hpp"
+#include "Core/FixedTimestep.hpp"
+#include "Core/Input.hpp"
+#include "Core/InputRecording.hpp"
+#include "Core/JobSystem.hpp"
+#include "Core/Profiler.hpp"
+#include "Core/SceneHierarchy.hpp"
+#include "Core/TickInput.hpp"
+#include "Core/Transform.hpp"
+#include "Core/TripleBuffer.hpp"
+#include "ECS/World.hpp"
+#include "ECS/Components.hpp"
+#include "ECS/SystemScheduler.hpp"
+#include "Physics/BodyWorld.hpp"
+#include "Physics/CharacterController.hpp"
+#include "Physics/DynamicTree.hpp"
+#include "Physics/Narrowphase.hpp"
+#include "Physics/RigidBodyWorld.hpp"
+#include "Physics/SpatialHash.hpp"
+#include "Physics/StaticGeometry.hpp"
 
 #include <ft2build.h>
 #include FT_FREETYPE_H  
@@ -25,14 +60,50 @@ const unsigned int ARRAY_LIMIT = 400;
 unsigned int VBO, VAO, EBO;
 unsigned int TVAO, TVBO;
 GLuint SSBO;
+GLuint FrameSSBO;
 
 float Zoom = 500.0f;
-float deltaTime = 0.0f;
-float lastFrame = 0.0f;
+double deltaTime = 0.0;
+double lastFrame = 0.0;
 float playerSpeed = 10.0f;
+const double TICK_RATE = 60.0;
+const int SWAP_INTERVAL = 1;
+const int MAX_FRAMES_IN_FLIGHT = 2;
+const double TARGET_FRAME_RATE = 0.0; // 0 = let the swap interval decide
+const bool LATE_LATCH = true;         // pace first, then grab the newest packet right before drawing
+const int PROFILE_CAPTURE_FRAMES = 0;   // write profile.json after this many frames, 0 = only when F11 is pressed
+JobSystem* jobs = nullptr;
+GpuProfiler* gpuProfiler = nullptr;     // owned by the render thread
+TilemapRenderer<Tilemap>* tilemapRenderer = nullptr; // owned by the render thread
+std::atomic<bool> captureRequested = false;
+std::atomic<bool> overlayVisible = false;
+RenderStats renderStats;                // render thread only, reset every frame
+const int SOLID_GLYPH = 0;              // glyph array layer filled solid for the overlay, NUL is never drawn as text
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void processInput(GLFWwindow* window);
+void bindActions(ActionMap& map);
+TickInput processInput(GLFWwindow* window, const ActionFrame& actions);
+void BenchJobs(size_t spriteCount);
+void BenchECS(size_t entityCount);
+void BenchSystems(size_t entityCount);
+void BenchScene(size_t nodeCount);
+void BenchBroadphase(size_t colliderCount);
+void BenchTree(size_t objectCount);
+void BenchNarrowphase(size_t pairCount);
+void BenchCCD(size_t moverCount);
+void BenchFixed(size_t bodyCount);
+int BenchRigidBodies(size_t boxCount);
+void BenchCompressedTexture(const std::string& imagePath);
+void BenchFill(int layers, const std::string& imagePath);
+void BenchTilemap(int frameCount);
+void BenchStream(const std::string& path, int frameCount);
+void CreateWorld(uint16_t playerFrame, uint16_t crateFrame);
+void CreateLevelTiles(const SpriteSheet& sheet);
+void simulate(float dt, const TickInput& input);
+uint64_t stateHash();
+int ReplayInput(const std::string& filepath);
+void WritePacket(FramePacket& packet, double tickTime, double tickSeconds, double inputTime);
+void RenderFrame(const FramePacket& packet, double now, Shader& shader, Shader& tileShader, Shader& textShader, Texture& image, const SpriteSheet& sheet);
 void RenderText(Shader& shader, std::string text, float x, float y, float scale, glm::vec3 color);
 void TextRenderCall(int length, GLuint shader);
 void APIENTRY glDebugOutput(GLenum source, GLenum type, unsigned int id, GLenum severity, GLsizei length, const char* message, const void* userParam);
@@ -51,36 +122,43 @@ std::map<GLchar, Character> Characters;
 GLuint textureArray;
 std::vector<int>letterMap;
 
-struct Transform
+World world;
+Entity player;
+SystemScheduler systems;
+StaticGeometry level;   // walls the player slides along
+SpatialHash colliders;  // every Collider entity where it stood at the start of the tick
+std::vector<AABB> colliderBoxes;
+std::vector<uint32_t> colliderOf; // by entity index, the entity's box in colliderBoxes
+Tilemap levelTiles(256, 256, 0.25f, glm::vec2(-32.0f)); // filled before the render thread starts, which owns it from then on
+float tickDt = 0.0f;   // what the systems of the running tick see
+TickInput tickInput;
+// action indices, the simulation ones double as TickInput bits
+enum Action
 {
-	glm::vec3 position = glm::vec3(0.0f);
-	glm::vec3 rotation = glm::vec3(0.0f);
-	glm::vec3 scale = glm::vec3(1.0f);
-	glm::mat4 to_mat4() const
-	{
-		glm::mat4 m = glm::translate(glm::mat4(1.0f), position);
-		m *= glm::mat4_cast(glm::quat(rotation));
-		m = glm::scale(m, scale);
-		return m;
-	}
+	ActionMoveUp,
+	ActionMoveDown,
+	ActionMoveLeft,
+	ActionMoveRight,
+	ActionQuit,
+	ActionToggleOverlay,
+	ActionCaptureProfile,
 };
-Transform transform;
+static_assert(TickInput::MoveUp == 1u << ActionMoveUp && TickInput::MoveDown == 1u << ActionMoveDown &&
+	TickInput::MoveLeft == 1u << ActionMoveLeft && TickInput::MoveRight == 1u << ActionMoveRight, "TickInput bits must match the move actions");
 
 struct Vertex
 {
 	glm::vec2 position;
-	glm::vec2 texCoords;
+	glm::vec2 corner; // 0 or 1 per axis, the shader maps it into the sprite's frame rect
 };
 
 std::vector<Vertex> vertices;
 std::vector<glm::mat4> transforms;
+std::vector<uint16_t> spriteFrames; // one SpriteSheet frame index per quad
 std::vector<glm::mat4>T;
 
-void CreateQuad(const Transform& t, float width, float height, float Sprite_Width, float Sprite_height)
+void CreateQuad(const Transform& t, float width, float height, uint16_t frame)
 {
-	float x = 3, y = 4;
-	float sheet_Width = 260.0f, sheet_height = 261.0f;
-
 	Vertex v0;
 	Vertex v1;
 	Vertex v2;
@@ -89,10 +167,10 @@ void CreateQuad(const Transform& t, float width, float height, float Sprite_Widt
 	v1.position = glm::vec2(0.5f * width, -0.5f * height);
 	v2.position = glm::vec2(0.5f * width, 0.5f * height);
 	v3.position = glm::vec2(-0.5f * width, 0.5f * height);
-	v0.texCoords = glm::vec2((x + 0.f) * (Sprite_Width / sheet_Width), (y + 1.f) * (Sprite_height / sheet_height));
-	v1.texCoords = glm::vec2((x + 1.f) * (Sprite_Width / sheet_Width), (y + 1.f) * (Sprite_height / sheet_height));
-	v2.texCoords = glm::vec2((x + 1.f) * (Sprite_Width / sheet_Width), (y + 0.f) * (Sprite_height / sheet_height));
-	v3.texCoords = glm::vec2((x + 0.f) * (Sprite_Width / sheet_Width), (y + 0.f) * (Sprite_height / sheet_height));
+	v0.corner = glm::vec2(0.0f, 1.0f);
+	v1.corner = glm::vec2(1.0f, 1.0f);
+	v2.corner = glm::vec2(1.0f, 0.0f);
+	v3.corner = glm::vec2(0.0f, 0.0f);
 	vertices.push_back(v0);
 	vertices.push_back(v1);
 	vertices.push_back(v3);
@@ -101,6 +179,7 @@ void CreateQuad(const Transform& t, float width, float height, float Sprite_Widt
 	vertices.push_back(v3);
 
 	transforms.push_back(t.to_mat4());
+	spriteFrames.push_back(frame);
 
 	glGenBuffers(1, &VBO);
 	glGenVertexArrays(1, &VAO);
@@ -113,12 +192,140 @@ void CreateQuad(const Transform& t, float width, float height, float Sprite_Widt
 	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 1 * sizeof(Vertex), (void*)offsetof(Vertex, position));
 	glEnableVertexAttribArray(0);
 
-	// texture coord attribute
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 1 * sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+	// frame corner attribute
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 1 * sizeof(Vertex), (void*)offsetof(Vertex, corner));
 	glEnableVertexAttribArray(1);
 }
 
-int main() {
+int main(int argc, char** argv) {
+
+	// 2D-Game --headless <ticks>: run the simulation uncapped without a window
+	if (argc >= 3 && std::string(argv[1]) == "--headless")
+	{
+		long long tickCount = std::atoll(argv[2]);
+		CreateWorld(0, 0);
+		Clock clock;
+		for (long long i = 0; i < tickCount; i++)
+			simulate(float(1.0 / TICK_RATE), TickInput());
+		double seconds = clock.seconds();
+		std::cout << tickCount << " ticks in " << seconds * 1000.0 << " ms (" << tickCount / seconds << " ticks/s)" << std::endl;
+		return 0;
+	}
+
+	// 2D-Game --bench-jobs [sprites]: transform update scaling from 1 to N workers
+	if (argc >= 2 && std::string(argv[1]) == "--bench-jobs")
+	{
+		BenchJobs(argc >= 3 ? size_t(std::atoll(argv[2])) : 1000000);
+		return 0;
+	}
+
+	// 2D-Game --replay <trace>: run a recorded session without a window as fast as possible
+	if (argc >= 3 && std::string(argv[1]) == "--replay")
+		return ReplayInput(argv[2]);
+
+	// 2D-Game --record <trace>: play normally and save every tick's input on exit
+	std::string recordPath = argc >= 3 && std::string(argv[1]) == "--record" ? argv[2] : "";
+	InputRecorder recorder;
+
+	// 2D-Game --bench-ecs [entities]: query iteration and add/remove churn
+	if (argc >= 2 && std::string(argv[1]) == "--bench-ecs")
+	{
+		BenchECS(argc >= 3 ? size_t(std::atoll(argv[2])) : 1000000);
+		return 0;
+	}
+
+	// 2D-Game --bench-systems [entities]: parallel system schedule against a serial run
+	if (argc >= 2 && std::string(argv[1]) == "--bench-systems")
+	{
+		BenchSystems(argc >= 3 ? size_t(std::atoll(argv[2])) : 200000);
+		return 0;
+	}
+
+	// 2D-Game --bench-scene [nodes]: dirty world matrix update with 1% of the nodes moving
+	if (argc >= 2 && std::string(argv[1]) == "--bench-scene")
+	{
+		BenchScene(argc >= 3 ? size_t(std::atoll(argv[2])) : 100000);
+		return 0;
+	}
+
+	// 2D-Game --bench-broadphase [colliders]: spatial hash rebuild of moving boxes from 1 to N workers
+	if (argc >= 2 && std::string(argv[1]) == "--bench-broadphase")
+	{
+		BenchBroadphase(argc >= 3 ? size_t(std::atoll(argv[2])) : 100000);
+		return 0;
+	}
+
+	// 2D-Game --bench-tree [objects]: dynamic AABB tree with 10% moving and 10k queries per frame
+	if (argc >= 2 && std::string(argv[1]) == "--bench-tree")
+	{
+		BenchTree(argc >= 3 ? size_t(std::atoll(argv[2])) : 100000);
+		return 0;
+	}
+
+	// 2D-Game --bench-narrowphase [pairs]: contact tests per second, scalar against the wide kernels
+	if (argc >= 2 && std::string(argv[1]) == "--bench-narrowphase")
+	{
+		BenchNarrowphase(argc >= 3 ? size_t(std::atoll(argv[2])) : 1000000);
+		return 0;
+	}
+
+	// 2D-Game --bench-ccd [movers]: character controllers boxed in by thin walls at rising speeds
+	if (argc >= 2 && std::string(argv[1]) == "--bench-ccd")
+	{
+		BenchCCD(argc >= 3 ? size_t(std::atoll(argv[2])) : 10000);
+		return 0;
+	}
+
+	// 2D-Game --bench-fixed [bodies]: the same box world stepped in float and in Fixed, with the per-tick hash
+	if (argc >= 2 && std::string(argv[1]) == "--bench-fixed")
+	{
+		BenchFixed(argc >= 3 ? size_t(std::atoll(argv[2])) : 10000);
+		return 0;
+	}
+
+	// 2D-Game --bench-rigid [boxes]: stacks of boxes settling and falling asleep, from 1 to N workers,
+	// then perfectly aligned stacks that have to fall asleep; exits with 1 when they do not
+	if (argc >= 2 && std::string(argv[1]) == "--bench-rigid")
+	{
+		return BenchRigidBodies(argc >= 3 ? size_t(std::atoll(argv[2])) : 10000);
+	}
+
+	// 2D-Game --bench-tilemap [frames]: CPU side of the chunked tilemap per frame on maps up to 4096x4096
+	if (argc >= 2 && std::string(argv[1]) == "--bench-tilemap")
+	{
+		BenchTilemap(argc >= 3 ? std::atoi(argv[2]) : 1000);
+		return 0;
+	}
+
+	// 2D-Game --bench-stream [file.tmap] [frames]: fly along the surface of a 100000x100000 streamed world, written first if missing
+	if (argc >= 2 && std::string(argv[1]) == "--bench-stream")
+	{
+		BenchStream(argc >= 3 ? argv[2] : "stream-bench.tmap", argc >= 4 ? std::atoi(argv[3]) : 3000);
+		return 0;
+	}
+
+	// 2D-Game --bench-ctex [image]: file size, VRAM and CPU load time of an image against its .ctex encodings
+	if (argc >= 2 && std::string(argv[1]) == "--bench-ctex")
+	{
+		BenchCompressedTexture(argc >= 3 ? argv[2] : "Resource/Textures/spritesheet.jpg");
+		return 0;
+	}
+
+	// 2D-Game --bench-fill [layers] [image]: GPU time of full screen texture layers at falling zoom, with and without mips
+	if (argc >= 2 && std::string(argv[1]) == "--bench-fill")
+	{
+		BenchFill(argc >= 3 ? std::atoi(argv[2]) : 8, argc >= 4 ? argv[3] : "Resource/Textures/spritesheet.jpg");
+		return 0;
+	}
+
+	// offline step: 2D-Game --compress <input image> <output.ctex> [bc1|bc3|bc7]
+	if (argc >= 4 && std::string(argv[1]) == "--compress")
+	{
+		std::string format = argc >= 5 ? argv[4] : "bc7";
+		BlockFormat blockFormat = format == "bc1" ? BlockFormat::BC1 : format == "bc3" ? BlockFormat::BC3 : BlockFormat::BC7;
+		stbi_set_flip_vertically_on_load(false);
+		return TextureCompressor::compressFile(argv[2], argv[3], blockFormat) ? 0 : -1;
+	}
 
 	glfwInit();
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -150,10 +357,16 @@ int main() {
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-	Shader shader("Resource/Shaders/Main-Shader.vert", "Resource/Shaders/Main-Shader.frag");
-	Shader Text_Render("Resource/Shaders/Text-Render.vert", "Resource/Shaders/Text-Render.frag");
+	TextureResidency residency(256 * 1024 * 1024);
+	ResourceRegistry resources(&residency);
+	ResourceHandle<Shader> shader = resources.loadShader("Resource/Shaders/Main-Shader.vert", "Resource/Shaders/Main-Shader.frag");
+	ResourceHandle<Shader> tileShader = resources.loadShader("Resource/Shaders/Tilemap.vert", "Resource/Shaders/Main-Shader.frag");
+	ResourceHandle<Shader> Text_Render = resources.loadShader("Resource/Shaders/Text-Render.vert", "Resource/Shaders/Text-Render.frag");
 	stbi_set_flip_vertically_on_load(false);
-	Texture image("Resource/Textures/spritesheet.jpg");
+	// prefer the block compressed copy made with --compress when it exists
+	ResourceHandle<Texture> image = resources.loadTexture(std::filesystem::exists("Resource/Textures/spritesheet.ctex") ? "Resource/Textures/spritesheet.ctex" : "Resource/Textures/spritesheet.jpg");
+	resources.printStats();
+	SpriteSheet sheet("Resource/Textures/spritesheet.sheet");
 
 	FT_Library ft;
 	// All functions return a value different than 0 whenever an error occurred
@@ -221,6 +434,8 @@ int main() {
 			};
 			Characters.insert(std::pair<char, Character>(c, character));
 		}
+		std::vector<unsigned char> solid(256 * 256, 255);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, SOLID_GLYPH, 256, 256, 1, GL_RED, GL_UNSIGNED_BYTE, solid.data());
 		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 	}
 	// destroy FreeType once we're finished
@@ -256,108 +471,1453 @@ int main() {
 	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, SSBO);
 	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-	Transform t;
-	CreateQuad(t, 1.0f, 1.0f, 65.0f, 65.0f);
+	glGenBuffers(1, &FrameSSBO);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, FrameSSBO);
+
+	CreateWorld(sheet.frame(3, 0), sheet.frame(0, 1));
+	CreateLevelTiles(sheet);
+	// one quad per sprite, in the order WritePacket walks them; scale comes from the transform
+	world.each<Sprite>([&](Sprite& sprite) {
+		CreateQuad(Transform(), 1.0f, 1.0f, sprite.frame);
+	});
+
+	PerfOverlay overlay(SOLID_GLYPH);
+	for (const auto& [c, character] : Characters)
+		overlay.setGlyph((unsigned char)c, character.Bearing, character.Advance);
+
+	Clock clock;
+	FixedTimestep simulation(TICK_RATE);
+	InputSystem input(clock);
+	input.attach(window);
+	bindActions(input.actions());
+	JobSystem jobSystem;
+	jobs = &jobSystem;
+
+	// The render thread owns the GL context from here on. The game thread (this one, GLFW wants
+	// events polled on the main thread) simulates and publishes one FramePacket per tick.
+	TripleBuffer<FramePacket> mailbox;
+	WritePacket(mailbox.write(), clock.seconds(), simulation.step(), -1.0);
+	mailbox.publish();
+
+	std::atomic<bool> running = true;
+	glfwMakeContextCurrent(NULL);
+	std::thread renderThread([&]() {
+		PROFILE_THREAD("Render");
+		glfwMakeContextCurrent(window);
+		glfwSwapInterval(SWAP_INTERVAL);
+		{
+			FramePacer pacer(clock, MAX_FRAMES_IN_FLIGHT, TARGET_FRAME_RATE);
+			GpuProfiler gpu;
+			gpuProfiler = &gpu;
+			TilemapRenderer<Tilemap> tiles(levelTiles, sheet);
+			tilemapRenderer = &tiles;
+			int frameNumber = 0;
+			double lastPresent = clock.seconds();
+			while (running.load(std::memory_order_relaxed))
+			{
+				{
+					PROFILE_SCOPE("Pace");
+					if (LATE_LATCH)
+						pacer.waitForFrame();
+				}
+				bool fresh = mailbox.update();
+				if (!LATE_LATCH)
+					pacer.waitForFrame();
+				const FramePacket& packet = mailbox.read();
+				gpu.beginFrame();
+				renderStats.reset();
+				double frameStart = clock.seconds();
+				RenderFrame(packet, clock.seconds(), *shader, *tileShader, *Text_Render, *image, sheet);
+				if (overlayVisible.load(std::memory_order_relaxed))
+				{
+					PROFILE_SCOPE("Overlay");
+					PerfOverlay::Sample sample;
+					sample.stats = renderStats;
+					sample.cpuSeconds = clock.seconds() - frameStart;
+					sample.gpuSeconds = gpu.lastFrameSeconds();
+					sample.textureBytes = residency.residentMemory();
+					sample.textureBudget = residency.budget();
+					sample.shaderBytes = resources.shaderMemory().bytes;
+					overlay.draw(*Text_Render, TVAO, textureArray, packet.viewportWidth, packet.viewportHeight, sample);
+				}
+				residency.endFrame();
+				{
+					PROFILE_SCOPE("Swap");
+					glfwSwapBuffers(window);
+				}
+				pacer.framePresented(fresh ? packet.inputTime : -1.0);
+				double presented = clock.seconds();
+				overlay.addFrameTime(presented - lastPresent);
+				lastPresent = presented;
+
+				frameNumber++;
+				if (captureRequested.exchange(false) || frameNumber == PROFILE_CAPTURE_FRAMES)
+					Profiler::exportChromeTrace("profile.json");
+			}
+			gpuProfiler = nullptr;
+			tilemapRenderer = nullptr;
+		}
+		glfwMakeContextCurrent(NULL);
+	});
 
+	PROFILE_THREAD("Game");
 	while (!glfwWindowShouldClose(window))
 	{
-		//Inputs
-		processInput(window);
-
-		//Render
-		glClearColor(0.1f, 0.3f, 0.3f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT);
-
-		float currentFrame = glfwGetTime();
+		double currentFrame = clock.seconds();
 		deltaTime = currentFrame - lastFrame;
 		lastFrame = currentFrame;
 
-		shader.use();
+		//Inputs, the callbacks already queued everything up to the last wait
+		{
+			PROFILE_SCOPE("Input");
+			input.pollGamepads();
+		}
 
-		float left = -Screen_width / (2.0f * Zoom);
-		float right = Screen_width / (2.0f * Zoom);
-		float bottom = -Screen_Height / (2.0f * Zoom);
-		float top = Screen_Height / (2.0f * Zoom);
+		//Simulation, fixed ticks. Each tick only sees the events from its own slice of real time.
+		int ticks = simulation.advance(deltaTime);
+		{
+			PROFILE_SCOPE("Simulate");
+			double tickEnd = currentFrame - simulation.alpha() * simulation.step() - (ticks - 1) * simulation.step();
+			for (int i = 0; i < ticks; i++, tickEnd += simulation.step())
+			{
+				TickInput tickInput = processInput(window, input.consumeUntil(tickEnd));
+				if (!recordPath.empty())
+					recorder.record(tickInput);
+				simulate(float(simulation.step()), tickInput);
+			}
+		}
+		if (ticks > 0)
+		{
+			PROFILE_SCOPE("WritePacket");
+			WritePacket(mailbox.write(), currentFrame, simulation.step(), currentFrame);
+			mailbox.publish();
+		}
 
-		glm::mat4 view = glm::mat4(1.0f);
-		glm::mat4 projection = glm::mat4(1.0f);
+		// sleep until the next tick is due, waking early for input
+		glfwWaitEventsTimeout(simulation.step() * (1.0 - simulation.alpha()));
+	}
 
-		projection = glm::ortho(left, right, bottom, top, -0.1f, 100.0f);
-		view = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
+	running = false;
+	renderThread.join();
+	if (!recordPath.empty())
+		recorder.save(recordPath, TICK_RATE, stateHash());
+	glfwMakeContextCurrent(window);
 
-		shader.setMat4("projection", projection);
-		shader.setMat4("view", view);
+	// GL objects have to go before the context does
+	sheet.cleanUp();
+	shader.reset();
+	tileShader.reset();
+	Text_Render.reset();
+	image.reset();
 
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
-		glBufferData(GL_SHADER_STORAGE_BUFFER, vertices.size() * sizeof(Vertex), NULL, GL_DYNAMIC_DRAW);
-		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, transforms.size() * sizeof(glm::mat4), transforms.data());
-		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glfwTerminate();
+	return 0;
+}
 
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), NULL, GL_DYNAMIC_DRAW);
-		glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+// runs on the game thread, the render thread picks the new size up from the next packet
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+	Screen_width = width;
+	Screen_Height = height;
+}
 
-		image.bind(0);
+void bindActions(ActionMap& map)
+{
+	map.bind(InputDevice::Key, GLFW_KEY_W, ActionMoveUp);
+	map.bind(InputDevice::Key, GLFW_KEY_S, ActionMoveDown);
+	map.bind(InputDevice::Key, GLFW_KEY_A, ActionMoveLeft);
+	map.bind(InputDevice::Key, GLFW_KEY_D, ActionMoveRight);
+	map.bind(InputDevice::Key, GLFW_KEY_UP, ActionMoveUp);
+	map.bind(InputDevice::Key, GLFW_KEY_DOWN, ActionMoveDown);
+	map.bind(InputDevice::Key, GLFW_KEY_LEFT, ActionMoveLeft);
+	map.bind(InputDevice::Key, GLFW_KEY_RIGHT, ActionMoveRight);
+
+	map.bind(InputDevice::GamepadButton, GLFW_GAMEPAD_BUTTON_DPAD_UP, ActionMoveUp);
+	map.bind(InputDevice::GamepadButton, GLFW_GAMEPAD_BUTTON_DPAD_DOWN, ActionMoveDown);
+	map.bind(InputDevice::GamepadButton, GLFW_GAMEPAD_BUTTON_DPAD_LEFT, ActionMoveLeft);
+	map.bind(InputDevice::GamepadButton, GLFW_GAMEPAD_BUTTON_DPAD_RIGHT, ActionMoveRight);
+	// stick y points down in GLFW
+	map.bind(InputDevice::GamepadAxis, GLFW_GAMEPAD_AXIS_LEFT_Y * 2, ActionMoveUp);
+	map.bind(InputDevice::GamepadAxis, GLFW_GAMEPAD_AXIS_LEFT_Y * 2 + 1, ActionMoveDown);
+	map.bind(InputDevice::GamepadAxis, GLFW_GAMEPAD_AXIS_LEFT_X * 2, ActionMoveLeft);
+	map.bind(InputDevice::GamepadAxis, GLFW_GAMEPAD_AXIS_LEFT_X * 2 + 1, ActionMoveRight);
+
+	map.bind(InputDevice::Key, GLFW_KEY_ESCAPE, ActionQuit);
+	map.bind(InputDevice::GamepadButton, GLFW_GAMEPAD_BUTTON_BACK, ActionQuit);
+	map.bind(InputDevice::Key, GLFW_KEY_F3, ActionToggleOverlay);
+	// F11 writes a Chrome trace (chrome://tracing or ui.perfetto.dev) of what the rings still hold
+	map.bind(InputDevice::Key, GLFW_KEY_F11, ActionCaptureProfile);
+}
 
-		glBindVertexArray(VAO);
-		glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+// runs once per tick, turns the tick's actions into window commands and simulation input
+TickInput processInput(GLFWwindow* window, const ActionFrame& actions)
+{
+	if (actions.wasPressed(ActionQuit))
+		glfwSetWindowShouldClose(window, true);
+
+	if (actions.wasPressed(ActionCaptureProfile))
+		captureRequested = true;
 
-		left = 0;
-		right = Screen_width;
-		bottom = 0;
-		top = Screen_Height;
-		projection = glm::ortho(left, right, bottom, top, -1.0f, 1.0f);
+	if (actions.wasPressed(ActionToggleOverlay))
+		overlayVisible = !overlayVisible;
 
-		Text_Render.use();
-		Text_Render.setMat4("projection", projection);
-		RenderText(Text_Render, "Hello There", 0.0f, 5.0f, 5.0f, glm::vec3(0.2, 0.5f, 0.6f));
+	TickInput tickInput;
+	tickInput.buttons = (actions.held | actions.pressed) & (TickInput::MoveUp | TickInput::MoveDown | TickInput::MoveLeft | TickInput::MoveRight);
+	return tickInput;
+}
 
-		glfwPollEvents();
-		glfwSwapBuffers(window);
+// a floor from the bottom row of the sheet with holes, bigger than the screen so only a few chunks draw,
+// and the level walls on top of it. Runs after CreateWorld, which places the walls.
+void CreateLevelTiles(const SpriteSheet& sheet)
+{
+	uint32_t seed = 7;
+	for (int y = 0; y < levelTiles.getHeight(); y++)
+		for (int x = 0; x < levelTiles.getWidth(); x++)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			int pick = int(seed >> 28);
+			levelTiles.set(x, y, pick < 4 ? sheet.frame(pick, 3) : Tilemap::EMPTY);
+		}
 
+	float inverseTile = 1.0f / levelTiles.getTileSize();
+	for (uint32_t id = 0; id < level.size(); id++)
+	{
+		const AABB& wall = level.box(id);
+		glm::ivec2 lo = glm::ivec2(glm::floor((wall.min - levelTiles.getOrigin()) * inverseTile + 0.5f));
+		glm::ivec2 hi = glm::ivec2(glm::floor((wall.max - levelTiles.getOrigin()) * inverseTile + 0.5f));
+		for (int y = lo.y; y < hi.y; y++)
+			for (int x = lo.x; x < hi.x; x++)
+				levelTiles.set(x, y, sheet.frame(2, 2));
 	}
+}
 
-	glfwTerminate();
+void CreateWorld(uint16_t playerFrame, uint16_t crateFrame)
+{
+	// a room filling the default view (3.84 x 2.16 units at zoom 500), walls on the 0.25 tile grid
+	level.add({ glm::vec2(-1.75f, -1.0f), glm::vec2(-1.5f, 1.0f) });
+	level.add({ glm::vec2(1.5f, -1.0f), glm::vec2(1.75f, 1.0f) });
+	level.add({ glm::vec2(-1.5f, -1.0f), glm::vec2(1.5f, -0.75f) });
+	level.add({ glm::vec2(-1.5f, 0.75f), glm::vec2(1.5f, 1.0f) });
+
+	player = world.create(Transform(), PreviousTransform(), Sprite{ playerFrame }, Collider(), PlayerControlled());
+	for (glm::vec2 at : { glm::vec2(-1.3f, 0.55f), glm::vec2(1.3f, -0.55f) })
+	{
+		Transform crate;
+		crate.position = glm::vec3(at, 0.0f);
+		crate.scale = glm::vec3(0.4f);
+		world.create(crate, PreviousTransform{ crate }, Sprite{ crateFrame }, Collider{ glm::vec2(0.2f) });
+	}
+
+	systems.add("SavePrevious", componentMask<Transform>(), componentMask<PreviousTransform>(), [](World& w, CommandBuffer&) {
+		w.each<Transform, PreviousTransform>([](Transform& t, PreviousTransform& previous) {
+			previous.value = t;
+		});
+	});
+	systems.add("Velocity", componentMask<Velocity>(), componentMask<Transform>(), [](World& w, CommandBuffer&) {
+		float dt = tickDt;
+		w.each<Transform, Velocity>([dt](Transform& t, Velocity& velocity) {
+			t.position += glm::vec3(velocity.value * dt, 0.0f);
+		});
+	});
+	// reads Transform, so it runs before PlayerMove writes it and the sweeps see the start of the tick;
+	// the index it rebuilds is declared as ColliderIndex, which orders it before PlayerMove on its own
+	systems.add("Broadphase", componentMask<Transform, Collider>(), componentMask<ColliderIndex>(), [](World& w, CommandBuffer&) {
+		colliderBoxes.clear();
+		w.forEachChunk<Transform, Collider>([](size_t count, Entity* entities, Transform* t, Collider* collider) {
+			for (size_t i = 0; i < count; i++)
+			{
+				if (colliderOf.size() <= entities[i].index)
+					colliderOf.resize(entities[i].index + 1, SweepHit::NONE);
+				colliderOf[entities[i].index] = uint32_t(colliderBoxes.size());
+				colliderBoxes.push_back(AABB::fromCenter(glm::vec2(t[i].position), collider[i].halfExtents));
+			}
+		});
+		colliders.setCellSize(SpatialHash::suggestCellSize(colliderBoxes.data(), colliderBoxes.size()));
+		colliders.build(colliderBoxes.data(), colliderBoxes.size());
+	});
+	systems.add("PlayerMove", componentMask<PlayerControlled, Collider, ColliderIndex>(), componentMask<Transform>(), [](World& w, CommandBuffer&) {
+		glm::vec2 move = tickInput.move() * playerSpeed * tickDt;
+		w.forEachChunk<Transform, Collider, PlayerControlled>([move](size_t count, Entity* entities, Transform* t, Collider* collider, PlayerControlled*) {
+			for (size_t i = 0; i < count; i++)
+			{
+				// swept against the level and the other colliders, so no speed or tick length can carry
+				// the player through a wall or a crate
+				AABB box = AABB::fromCenter(glm::vec2(t[i].position), collider[i].halfExtents);
+				uint32_t self = colliderOf[entities[i].index];
+				CharacterController::Result moved = CharacterController::move(box, move, [self](const AABB& b, const glm::vec2& d) {
+					SweepHit wall = level.sweep(b, d);
+					SweepHit other = colliders.sweep(b, d, self);
+					return other.hit() && (!wall.hit() || other.time < wall.time) ? other : wall;
+				});
+				t[i].position += glm::vec3(moved.displacement, 0.0f);
+			}
+		});
+	});
+}
+
+// one fixed tick of game state, input only comes in through the argument
+void simulate(float dt, const TickInput& input)
+{
+	tickDt = dt;
+	tickInput = input;
+	systems.run(world, jobs);
+}
+
+// FNV-1a over the world state, equal hashes mean a replay reproduced the recorded run
+uint64_t stateHash()
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+	auto mix = [&hash](const void* data, size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ull;
+		}
+	};
+	world.each<Transform>([&mix](Transform& t) {
+		mix(&t.position, sizeof(t.position));
+		mix(&t.rotation, sizeof(t.rotation));
+		mix(&t.scale, sizeof(t.scale));
+	});
+	return hash;
+}
+
+int ReplayInput(const std::string& filepath)
+{
+	InputReplay replay;
+	if (!replay.load(filepath))
+		return -1;
+	CreateWorld(0, 0);
+
+	// one tick and one packet per frame, the same work the game thread does but never waiting
+	float step = float(1.0 / replay.tickRate());
+	FramePacket packet;
+	Clock clock;
+	int64_t tickMin = INT64_MAX, tickMax = 0, tickTotal = 0;
+	int64_t frameMin = INT64_MAX, frameMax = 0;
+	while (!replay.finished())
+	{
+		int64_t frameStart = clock.nanoseconds();
+		simulate(step, replay.next());
+		int64_t tickEnd = clock.nanoseconds();
+		WritePacket(packet, 0.0, step, 0.0);
+		int64_t frameEnd = clock.nanoseconds();
+
+		tickMin = std::min(tickMin, tickEnd - frameStart);
+		tickMax = std::max(tickMax, tickEnd - frameStart);
+		tickTotal += tickEnd - frameStart;
+		frameMin = std::min(frameMin, frameEnd - frameStart);
+		frameMax = std::max(frameMax, frameEnd - frameStart);
+	}
+	double seconds = clock.seconds();
+	double ticks = double(std::max<uint64_t>(replay.tickCount(), 1));
+
+	std::cout << replay.tickCount() << " ticks replayed in " << seconds * 1000.0 << " ms (" << ticks / seconds << " ticks/s)" << std::endl;
+	std::cout << "tick  min " << tickMin / 1000.0 << " us, avg " << tickTotal / ticks / 1000.0 << " us, max " << tickMax / 1000.0 << " us" << std::endl;
+	std::cout << "frame min " << frameMin / 1000.0 << " us, avg " << seconds * 1e6 / ticks << " us, max " << frameMax / 1000.0 << " us" << std::endl;
+
+	uint64_t hash = stateHash();
+	if (hash != replay.expectedStateHash())
+	{
+		std::cout << "REPLAY::State diverged, hash " << std::hex << hash << " expected " << replay.expectedStateHash() << std::dec << std::endl;
+		return 1;
+	}
+	std::cout << "State matches the recording (" << std::hex << hash << std::dec << ")" << std::endl;
 	return 0;
 }
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+void BenchJobs(size_t spriteCount)
 {
-	glViewport(0, 0, width, height);
-	Screen_width = width;
-	Screen_Height = height;
+	std::vector<Transform> sprites(spriteCount);
+	for (size_t i = 0; i < spriteCount; i++)
+	{
+		sprites[i].position = glm::vec3(float(i % 1000), float(i / 1000), 0.0f);
+		sprites[i].rotation = glm::vec3(0.0f, 0.0f, float(i) * 0.001f);
+	}
+	std::vector<glm::mat4> matrices(spriteCount);
+
+	const int iterations = 20;
+	double baseline = 0.0;
+	unsigned maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned workers = 1; workers <= maxWorkers; workers++)
+	{
+		JobSystem system(workers);
+		Clock clock;
+		for (int i = 0; i < iterations; i++)
+			system.parallelFor(0, spriteCount, 4096, [&](size_t first, size_t last) {
+				for (size_t s = first; s < last; s++)
+					matrices[s] = sprites[s].to_mat4();
+			});
+		double ms = clock.seconds() * 1000.0 / iterations;
+		if (workers == 1)
+			baseline = ms;
+		std::cout << workers << " workers: " << ms << " ms per update, " << baseline / ms << "x" << std::endl;
+	}
 }
 
-void processInput(GLFWwindow* window)
+void BenchECS(size_t entityCount)
 {
-	if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-		glfwSetWindowShouldClose(window, true);
+	World bench;
+	Clock clock;
+	std::vector<Entity> entities(entityCount);
+	for (size_t i = 0; i < entityCount; i++)
+	{
+		Transform t;
+		t.position = glm::vec3(float(i % 1000), float(i / 1000), 0.0f);
+		// every other entity also gets a sprite so the three component query sees half of them
+		if (i % 2 == 0)
+			entities[i] = bench.create(t, Velocity{ glm::vec2(1.0f, 0.5f) }, Sprite{ uint16_t(i) });
+		else
+			entities[i] = bench.create(t, Velocity{ glm::vec2(1.0f, 0.5f) });
+	}
+	std::cout << "create " << entityCount << " entities: " << clock.seconds() * 1000.0 << " ms" << std::endl;
+
+	const int iterations = 20;
+	const float dt = 1.0f / 60.0f;
+	clock = Clock();
+	for (int i = 0; i < iterations; i++)
+		bench.forEachChunk<Transform, Velocity>([dt](size_t count, Entity*, Transform* t, Velocity* v) {
+			for (size_t e = 0; e < count; e++)
+				t[e].position += glm::vec3(v[e].value * dt, 0.0f);
+		});
+	double ms = clock.seconds() * 1000.0 / iterations;
+	std::cout << "Transform+Velocity:        " << ms << " ms per pass, " << ms * 1e6 / entityCount << " ns per entity" << std::endl;
+
+	uint64_t frameSum = 0;
+	clock = Clock();
+	for (int i = 0; i < iterations; i++)
+		bench.forEachChunk<Transform, Velocity, Sprite>([dt, &frameSum](size_t count, Entity*, Transform* t, Velocity* v, Sprite* s) {
+			for (size_t e = 0; e < count; e++)
+			{
+				t[e].position += glm::vec3(v[e].value * dt, 0.0f);
+				frameSum += s[e].frame;
+			}
+		});
+	ms = clock.seconds() * 1000.0 / iterations;
+	std::cout << "Transform+Velocity+Sprite: " << ms << " ms per pass, " << ms * 1e6 / (entityCount / 2) << " ns per entity (" << frameSum % 10 << ")" << std::endl;
+
+	// churn: a tenth of the entities gain or lose a component every frame through deferred commands
+	CommandBuffer commands;
+	size_t perFrame = std::max<size_t>(entityCount / 10, 1);
+	uint64_t operations = 0;
+	clock = Clock();
+	for (int frame = 0; frame < iterations; frame++)
+	{
+		for (size_t i = 0; i < perFrame; i++)
+		{
+			Entity e = entities[(i * 7919 + (frame / 2) * perFrame) % entityCount];
+			if (frame % 2 == 0)
+				commands.add(e, PlayerControlled());
+			else
+				commands.remove<PlayerControlled>(e);
+		}
+		operations += commands.size();
+		bench.flush(commands);
+	}
+	ms = clock.seconds() * 1000.0;
+	std::cout << "churn: " << operations << " add/remove in " << ms << " ms, " << ms * 1e6 / double(operations) << " ns each, "
+		<< bench.archetypeCount() << " archetypes" << std::endl;
+}
+
+// gameplay-shaped systems over entityCount entities, scheduled serially and in parallel
+void BenchSystems(size_t entityCount)
+{
+	struct Animation { float time; float fps; uint16_t first; uint16_t count; };
+	struct Bounds { glm::vec2 min; glm::vec2 max; };
+	struct Health { float value; float regen; };
+	struct DrawMatrix { glm::mat4 value; };
+
+	World bench;
+	for (size_t i = 0; i < entityCount; i++)
+	{
+		Transform t;
+		t.position = glm::vec3(float(i % 1000), float(i / 1000), 0.0f);
+		t.rotation = glm::vec3(0.0f, 0.0f, float(i) * 0.01f);
+		bench.create(t, PreviousTransform(), Velocity{ glm::vec2(1.0f, 0.5f) }, Sprite(), Animation{ 0.0f, 12.0f, 0, 4 },
+			Bounds(), Health{ 50.0f, 1.0f }, DrawMatrix());
+	}
+
+	const float dt = 1.0f / 60.0f;
+	SystemScheduler scheduler;
+	scheduler.add("SavePrevious", componentMask<Transform>(), componentMask<PreviousTransform>(), [](World& w, CommandBuffer&) {
+		w.each<Transform, PreviousTransform>([](Transform& t, PreviousTransform& p) { p.value = t; });
+	});
+	scheduler.add("Movement", componentMask<Velocity>(), componentMask<Transform>(), [dt](World& w, CommandBuffer&) {
+		w.each<Transform, Velocity>([dt](Transform& t, Velocity& v) { t.position += glm::vec3(v.value * dt, 0.0f); });
+	});
+	scheduler.add("Animation", 0, componentMask<Animation, Sprite>(), [dt](World& w, CommandBuffer&) {
+		w.each<Animation, Sprite>([dt](Animation& a, Sprite& s) {
+			a.time += dt;
+			s.frame = uint16_t(a.first + uint16_t(a.time * a.fps) % a.count);
+		});
+	});
+	scheduler.add("Health", 0, componentMask<Health>(), [dt](World& w, CommandBuffer&) {
+		w.each<Health>([dt](Health& h) { h.value = std::min(100.0f, h.value + h.regen * dt); });
+	});
+	scheduler.add("Bounds", componentMask<Transform>(), componentMask<Bounds>(), [](World& w, CommandBuffer&) {
+		w.each<Transform, Bounds>([](Transform& t, Bounds& b) {
+			b.min = glm::vec2(t.position) - glm::vec2(t.scale) * 0.5f;
+			b.max = glm::vec2(t.position) + glm::vec2(t.scale) * 0.5f;
+		});
+	});
+	scheduler.add("RenderPrep", componentMask<Transform, Sprite>(), componentMask<DrawMatrix>(), [](World& w, CommandBuffer&) {
+		w.each<Transform, DrawMatrix>([](Transform& t, DrawMatrix& m) { m.value = t.to_mat4(); });
+	});
+
+	const int iterations = 20;
+	Clock clock;
+	for (int i = 0; i < iterations; i++)
+		scheduler.runSerial(bench);
+	double serial = clock.seconds() * 1000.0 / iterations;
+
+	JobSystem system;
+	clock = Clock();
+	for (int i = 0; i < iterations; i++)
+		scheduler.run(bench, &system);
+	double parallel = clock.seconds() * 1000.0 / iterations;
+
+	scheduler.printSchedule(std::cout);
+	std::cout << entityCount << " entities, " << system.workerCount() << " workers: serial " << serial << " ms, parallel " << parallel
+		<< " ms, " << serial / parallel << "x" << std::endl;
+}
+
+void BenchScene(size_t nodeCount)
+{
+	// characters with a few attachments, some of which carry their own (weapon -> muzzle flash)
+	SceneHierarchy scene;
+	std::vector<SceneHierarchy::NodeId> nodes;
+	nodes.reserve(nodeCount);
+	uint32_t seed = 1;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return seed >> 8;
+	};
+	while (nodes.size() < nodeCount)
+	{
+		Transform t;
+		t.position = glm::vec3(float(random() % 1000), float(random() % 1000), 0.0f);
+		SceneHierarchy::NodeId character = scene.create(SceneHierarchy::NONE, t);
+		nodes.push_back(character);
+		for (int a = 0; a < 4 && nodes.size() < nodeCount; a++)
+		{
+			t.position = glm::vec3(float(a) * 0.25f, 0.5f, 0.0f);
+			t.rotation = glm::vec3(0.0f, 0.0f, float(a));
+			SceneHierarchy::NodeId attachment = scene.create(character, t);
+			nodes.push_back(attachment);
+			if (a % 2 == 0 && nodes.size() < nodeCount)
+				nodes.push_back(scene.create(attachment, t));
+		}
+	}
+	scene.update();
+
+	const int frames = 50;
+	size_t moving = std::max<size_t>(nodeCount / 100, 1);
+	size_t updated = 0;
+	Clock clock;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		for (size_t i = 0; i < moving; i++)
+		{
+			SceneHierarchy::NodeId node = nodes[random() % nodes.size()];
+			Transform t = scene.local(node);
+			t.position.x += 0.01f;
+			scene.setLocal(node, t);
+		}
+		scene.update();
+		updated += scene.updatedCount();
+	}
+	double dirtyMs = clock.seconds() * 1000.0 / frames;
+
+	clock = Clock();
+	for (int frame = 0; frame < frames; frame++)
+		scene.updateAll();
+	double fullMs = clock.seconds() * 1000.0 / frames;
+
+	std::cout << nodeCount << " nodes, " << moving << " moving per frame (" << updated / frames << " world matrices updated with their subtrees)" << std::endl;
+	std::cout << "dirty update " << dirtyMs << " ms, full recompute " << fullMs << " ms, " << 100.0 * dirtyMs / fullMs << "% of full" << std::endl;
+}
+
+void BenchBroadphase(size_t colliderCount)
+{
+	// boxes of 0.5 to 1.5 units wandering a square sized for a few neighbours each
+	uint32_t seed = 1;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return float(seed >> 8) / 16777216.0f;
+	};
+	float side = std::sqrt(float(colliderCount)) * 2.5f;
+	std::vector<AABB> boxes(colliderCount);
+	std::vector<glm::vec2> velocities(colliderCount);
+	for (size_t i = 0; i < colliderCount; i++)
+	{
+		glm::vec2 extent(0.25f + random() * 0.5f, 0.25f + random() * 0.5f);
+		boxes[i] = AABB::fromCenter(glm::vec2(random(), random()) * side, extent);
+		velocities[i] = glm::vec2(random() - 0.5f, random() - 0.5f) * 4.0f;
+	}
+	SpatialHash hash(SpatialHash::suggestCellSize(boxes.data(), colliderCount));
+
+	const int ticks = 50;
+	const float dt = float(1.0 / TICK_RATE);
+	double baseline = 0.0;
+	unsigned maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned workers = 1; workers <= maxWorkers; workers++)
+	{
+		JobSystem system(workers);
+		JobSystem* jobs = workers == 1 ? nullptr : &system;
+		// untimed: the first build sizes the buffers, which a game pays once and not every tick
+		hash.build(boxes.data(), colliderCount, jobs);
+		size_t pairCount = 0;
+		double seconds = 0.0;
+		for (int tick = 0; tick < ticks; tick++)
+		{
+			for (size_t i = 0; i < colliderCount; i++)
+			{
+				boxes[i].min += velocities[i] * dt;
+				boxes[i].max += velocities[i] * dt;
+			}
+			Clock clock;
+			pairCount += hash.build(boxes.data(), colliderCount, jobs).size();
+			seconds += clock.seconds();
+		}
+		double ms = seconds * 1000.0 / ticks;
+		if (workers == 1)
+			baseline = ms;
+		std::cout << workers << " workers: " << ms << " ms per rebuild, " << pairCount / ticks << " pairs, "
+			<< hash.entryCount() << " cell entries, " << baseline / ms << "x" << std::endl;
+	}
+}
+
+void BenchTree(size_t objectCount)
+{
+	// sprite sizes spread over two orders of magnitude, from bullets to buildings
+	uint32_t seed = 1;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return float(seed >> 8) / 16777216.0f;
+	};
+	float side = std::sqrt(float(objectCount)) * 4.0f;
+	std::vector<AABB> boxes(objectCount);
+	std::vector<uint32_t> proxies(objectCount);
+	DynamicTree tree;
+	Clock clock;
+	for (size_t i = 0; i < objectCount; i++)
+	{
+		float size = 0.1f * std::pow(200.0f, random());
+		boxes[i] = AABB::fromCenter(glm::vec2(random(), random()) * side, glm::vec2(size, size * (0.5f + random())) * 0.5f);
+		proxies[i] = tree.create(boxes[i], uint32_t(i));
+	}
+	double buildMs = clock.seconds() * 1000.0;
+	std::cout << objectCount << " objects inserted in " << buildMs << " ms, height " << tree.height() << ", area ratio " << tree.areaRatio() << std::endl;
+
+	const int frames = 30;
+	const size_t queries = 10000;
+	size_t moving = std::max<size_t>(objectCount / 10, 1);
+	const float dt = float(1.0 / TICK_RATE);
+	double moveMs = 0.0, rayMs = 0.0, boxMs = 0.0, pointMs = 0.0;
+	size_t reinserted = 0, rayHits = 0, boxHits = 0, pointHits = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		// a different tenth every frame, each moving a few units per second
+		clock = Clock();
+		size_t first = (size_t(frame) * moving) % objectCount;
+		for (size_t m = 0; m < moving; m++)
+		{
+			size_t i = (first + m) % objectCount;
+			glm::vec2 displacement = glm::vec2(random() - 0.5f, random() - 0.5f) * 8.0f * dt;
+			boxes[i].min += displacement;
+			boxes[i].max += displacement;
+			reinserted += tree.move(proxies[i], boxes[i], displacement);
+		}
+		moveMs += clock.seconds() * 1000.0;
+
+		// closest hit along short rays, as a bullet or line of sight check would ask
+		clock = Clock();
+		for (size_t q = 0; q < queries / 3; q++)
+		{
+			glm::vec2 origin = glm::vec2(random(), random()) * side;
+			glm::vec2 end = origin + glm::vec2(random() - 0.5f, random() - 0.5f) * 40.0f;
+			glm::vec2 direction = end - origin;
+			glm::vec2 inverse(direction.x != 0.0f ? 1.0f / direction.x : 1e30f, direction.y != 0.0f ? 1.0f / direction.y : 1e30f);
+			bool hit = false;
+			tree.raycast(origin, end, [&](uint32_t proxy, float maxFraction) {
+				float fraction;
+				if (!boxes[tree.userData(proxy)].raycast(origin, inverse, maxFraction, fraction))
+					return -1.0f;
+				hit = true;
+				return fraction;
+			});
+			rayHits += hit;
+		}
+		rayMs += clock.seconds() * 1000.0;
+
+		// area of effect around a point
+		clock = Clock();
+		for (size_t q = 0; q < queries / 3; q++)
+		{
+			AABB area = AABB::fromCenter(glm::vec2(random(), random()) * side, glm::vec2(5.0f));
+			tree.query(area, [&](uint32_t proxy) {
+				boxHits += boxes[tree.userData(proxy)].overlaps(area);
+				return true;
+			});
+		}
+		boxMs += clock.seconds() * 1000.0;
+
+		// what is under the cursor, first hit only
+		clock = Clock();
+		for (size_t q = 0; q < queries - 2 * (queries / 3); q++)
+		{
+			glm::vec2 point = glm::vec2(random(), random()) * side;
+			tree.query(point, [&](uint32_t proxy) {
+				if (!boxes[tree.userData(proxy)].contains(point))
+					return true;
+				pointHits++;
+				return false;
+			});
+		}
+		pointMs += clock.seconds() * 1000.0;
+	}
+	std::cout << "per frame: move " << moving << " in " << moveMs / frames << " ms (" << reinserted / frames << " reinserted), "
+		<< queries / 3 << " rays " << rayMs / frames << " ms (" << rayHits / frames << " hit), "
+		<< queries / 3 << " areas " << boxMs / frames << " ms (" << boxHits / frames << " overlaps), "
+		<< queries - 2 * (queries / 3) << " points " << pointMs / frames << " ms (" << pointHits / frames << " hit)" << std::endl;
+	std::cout << "after " << frames << " frames: height " << tree.height() << ", area ratio " << tree.areaRatio() << std::endl;
+}
+
+void BenchNarrowphase(size_t pairCount)
+{
+	// every pair gets its own two shapes a short random offset apart, about half of them touching
+	uint32_t seed = 1;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return float(seed >> 8) / 16777216.0f;
+	};
+	size_t shapeCount = pairCount * 2;
+	std::vector<AABB> boxes(shapeCount);
+	std::vector<Circle> circles(shapeCount);
+	std::vector<OBB> obbs(shapeCount);
+	for (size_t i = 0; i < shapeCount; i++)
+	{
+		glm::vec2 center = glm::vec2(float(i / 2), 0.0f) * 10.0f + (i % 2 ? glm::vec2(random() - 0.5f, random() - 0.5f) * 4.0f : glm::vec2(0.0f));
+		glm::vec2 half(0.5f + random() * 0.5f, 0.5f + random() * 0.5f);
+		boxes[i] = AABB::fromCenter(center, half);
+		circles[i] = { center, half.x };
+		obbs[i] = OBB::fromAngle(center, half, random() * 6.2831853f);
+	}
+	std::vector<ColliderPair> pairs(pairCount);
+	for (size_t i = 0; i < pairCount; i++)
+		pairs[i] = { uint32_t(i * 2), uint32_t(i * 2 + 1) };
+
+	Narrowphase narrowphase;
+	ContactBuffer contacts;
+	contacts.reserve(pairCount);
+	const int iterations = 10;
+	auto measure = [&](const char* name, auto&& test) {
+		double seconds[2];
+		size_t found[2];
+		for (int wide = 0; wide < 2; wide++)
+		{
+			Clock clock;
+			for (int i = 0; i < iterations; i++)
+			{
+				contacts.clear();
+				test(wide == 1);
+			}
+			seconds[wide] = clock.seconds() / iterations;
+			found[wide] = contacts.size();
+		}
+		std::cout << "  " << name << ": scalar " << pairCount / seconds[0] * 1e-6 << " M pairs/s, " << narrowphase.wideLanes() << " wide "
+			<< pairCount / seconds[1] * 1e-6 << " M pairs/s, " << seconds[0] / seconds[1] << "x, " << found[1] << " contacts"
+			<< (found[0] == found[1] ? "" : " (scalar found a different count)") << std::endl;
+	};
+	// in order the gather streams through memory, shuffled every pair misses the cache twice
+	for (int shuffled = 0; shuffled < 2; shuffled++)
+	{
+		if (shuffled)
+			for (size_t i = pairCount - 1; i > 0; i--)
+				std::swap(pairs[i], pairs[size_t(random() * float(i + 1)) % (i + 1)]);
+		std::cout << (shuffled ? "Shuffled pairs" : "Pairs in memory order") << std::endl;
+		measure("AABB-AABB", [&](bool wide) {
+			wide ? narrowphase.collide(boxes.data(), pairs.data(), pairCount, contacts)
+				: narrowphase.collide<Simd::Scalar>(boxes.data(), pairs.data(), pairCount, contacts);
+		});
+		measure("circle-circle", [&](bool wide) {
+			wide ? narrowphase.collide(circles.data(), pairs.data(), pairCount, contacts)
+				: narrowphase.collide<Simd::Scalar>(circles.data(), pairs.data(), pairCount, contacts);
+		});
+		measure("circle-AABB", [&](bool wide) {
+			wide ? narrowphase.collide(circles.data(), boxes.data(), pairs.data(), pairCount, contacts)
+				: narrowphase.collide<Simd::Scalar>(circles.data(), boxes.data(), pairs.data(), pairCount, contacts);
+		});
+		measure("OBB-OBB", [&](bool wide) {
+			wide ? narrowphase.collide(obbs.data(), pairs.data(), pairCount, contacts)
+				: narrowphase.collide<Simd::Scalar>(obbs.data(), pairs.data(), pairCount, contacts);
+		});
+	}
+}
+
+void BenchCCD(size_t moverCount)
+{
+	// a grid of rooms walled in by slabs thinner than a single tick of movement at the higher
+	// speeds, four movers per room. A mover found outside its room afterwards tunnelled.
+	const float ROOM = 4.0f, WALL = 0.05f, HALF = 0.25f;
+	int rooms = std::max(1, int(std::ceil(std::sqrt(double(moverCount) / 4.0))));
+	float side = ROOM * float(rooms);
+	StaticGeometry walls;
+	for (int i = 0; i <= rooms; i++)
+	{
+		float at = ROOM * float(i);
+		walls.add({ glm::vec2(at - WALL * 0.5f, 0.0f), glm::vec2(at + WALL * 0.5f, side) });
+		walls.add({ glm::vec2(0.0f, at - WALL * 0.5f), glm::vec2(side, at + WALL * 0.5f) });
+	}
+
+	uint32_t seed = 1;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return float(seed >> 8) / 16777216.0f;
+	};
+	auto roomOf = [&](const AABB& box) {
+		glm::ivec2 room = glm::ivec2(glm::floor(box.center() / ROOM));
+		return room.y * rooms + room.x;
+	};
+
+	const int ticks = 60;
+	const float dt = float(1.0 / TICK_RATE);
+	std::vector<AABB> boxes(moverCount);
+	std::vector<glm::vec2> velocities(moverCount);
+	SpatialHash others(HALF * 4.0f);
+	for (float speed : { 2.0f, 20.0f, 200.0f, 2000.0f })
+	{
+		std::vector<int> startRoom(moverCount);
+		for (size_t i = 0; i < moverCount; i++)
+		{
+			glm::vec2 room = glm::vec2(float((i / 4) % rooms), float((i / 4) / rooms % rooms)) * ROOM;
+			glm::vec2 inside = glm::vec2(random(), random()) * (ROOM - 2.0f * (HALF + WALL)) + HALF + WALL;
+			boxes[i] = AABB::fromCenter(room + inside, glm::vec2(HALF));
+			float angle = random() * 6.2831853f;
+			velocities[i] = glm::vec2(std::cos(angle), std::sin(angle)) * speed;
+			startRoom[i] = roomOf(boxes[i]);
+		}
+
+		size_t hits = 0;
+		Clock clock;
+		for (int tick = 0; tick < ticks; tick++)
+		{
+			// movers collide with the walls and with where the others were at the start of the tick
+			others.build(boxes.data(), moverCount);
+			for (size_t i = 0; i < moverCount; i++)
+			{
+				CharacterController::Result moved = CharacterController::move(boxes[i], velocities[i] * dt, [&](const AABB& b, const glm::vec2& d) {
+					SweepHit wall = walls.sweep(b, d);
+					SweepHit mover = others.sweep(b, d, uint32_t(i));
+					return mover.hit() && (!wall.hit() || mover.time < wall.time) ? mover : wall;
+				});
+				if (moved.hits)
+				{
+					velocities[i] -= 2.0f * glm::dot(velocities[i], moved.normal) * moved.normal;
+					hits += moved.hits;
+				}
+			}
+		}
+		double ms = clock.seconds() * 1000.0 / ticks;
+
+		size_t escaped = 0;
+		for (size_t i = 0; i < moverCount; i++)
+			escaped += roomOf(boxes[i]) != startRoom[i];
+		std::cout << "speed " << speed << " (" << speed * dt << " units per tick, walls " << WALL << "): " << ms << " ms per tick, "
+			<< hits / ticks << " contacts per tick, " << escaped << " of " << moverCount << " movers left their room" << std::endl;
+	}
+}
+
+// One world per Real built from the same integers, so both start from exactly the same scene
+template<typename Real>
+double RunBodyWorld(size_t bodyCount, int ticks, uint64_t& tickHash, size_t& contacts)
+{
+	int32_t side = std::max(8, int32_t(std::sqrt(double(bodyCount))) * 2);
+	BodyWorld<Real> bodies({ realRatio<Real>(0, 1), realRatio<Real>(0, 1) }, { realRatio<Real>(side, 1), realRatio<Real>(side, 1) }, realRatio<Real>(1, 2));
+	uint32_t seed = 1;
+	auto random = [&seed](uint32_t range) {
+		seed = seed * 1664525u + 1013904223u;
+		return int32_t((seed >> 8) % range);
+	};
+	for (size_t i = 0; i < bodyCount; i++)
+	{
+		typename BodyWorld<Real>::Body body;
+		body.position = { realRatio<Real>(random(uint32_t(side) * 64), 64), realRatio<Real>(random(uint32_t(side) * 64), 64) };
+		body.velocity = { realRatio<Real>(random(512) - 256, 64), realRatio<Real>(random(512) - 256, 64) };
+		body.halfExtents = { realRatio<Real>(8 + random(8), 64), realRatio<Real>(8 + random(8), 64) };
+		body.inverseMass = i % 16 == 0 ? realRatio<Real>(0, 1) : realRatio<Real>(1, 1 + random(4));
+		bodies.add(body);
+	}
+
+	Real dt = realRatio<Real>(1, int32_t(TICK_RATE));
+	tickHash = 0;
+	contacts = 0;
+	Clock clock;
+	for (int tick = 0; tick < ticks; tick++)
+	{
+		bodies.step(dt);
+		// what a lockstep peer would send and compare every tick
+		tickHash = tickHash * 31 + bodies.stateHash();
+		contacts += bodies.contactCount();
+	}
+	contacts /= size_t(ticks);
+	return clock.seconds() * 1000.0 / ticks;
+}
+
+void BenchFixed(size_t bodyCount)
+{
+	const int ticks = 300;
+	uint64_t floatHash, fixedHash;
+	size_t floatContacts, fixedContacts;
+	double floatMs = RunBodyWorld<float>(bodyCount, ticks, floatHash, floatContacts);
+	double fixedMs = RunBodyWorld<Fixed>(bodyCount, ticks, fixedHash, fixedContacts);
+	std::cout << bodyCount << " bodies, " << ticks << " ticks" << std::endl;
+	std::cout << "float: " << floatMs << " ms per tick, " << floatContacts << " contacts per tick, hash " << std::hex << floatHash << std::dec << std::endl;
+	std::cout << "fixed: " << fixedMs << " ms per tick, " << fixedContacts << " contacts per tick, hash " << std::hex << fixedHash << std::dec
+		<< " (the same on every build)" << std::endl;
+	std::cout << "fixed / float: " << fixedMs / floatMs << "x" << std::endl;
+}
+
+void BenchFill(int layers, const std::string& imagePath)
+{
+	// full screen quads of the texture stacked layers deep into a 1920x1080 target, timed on the GPU
+	// with timestamp queries, from 1 texel per pixel down to 64 (far zoomed out), sampled through
+	// the mip chain and through level 0 only, which is what every texture did before it had mips
+	glfwInit();
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "2D-Game --bench-fill", NULL, NULL);
+	if (window == NULL)
+	{
+		std::cout << "GLFW Context is incorrect...You should fix it" << std::endl;
+		glfwTerminate();
+		return;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+	{
+		std::cout << "GLAD isn't initalized properly" << std::endl;
+		glfwTerminate();
+		return;
+	}
+	{
+		const int frames = 20;
+		Shader shader("Resource/Shaders/FillBench.vert", "Resource/Shaders/Main-Shader.frag");
+		Texture sheet(imagePath);
+
+		// an offscreen target, a hidden window's back buffer may not own its pixels
+		GLuint target, framebuffer, vao, samplers[2], queries[2];
+		glCreateTextures(GL_TEXTURE_2D, 1, &target);
+		glTextureStorage2D(target, 1, GL_RGBA8, Screen_width, Screen_Height);
+		glCreateFramebuffers(1, &framebuffer);
+		glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0, target, 0);
+		glCreateVertexArrays(1, &vao);
+		glCreateSamplers(2, samplers);
+		for (GLuint sampler : samplers)
+		{
+			glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		}
+		glSamplerParameteri(samplers[0], GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glSamplerParameteri(samplers[1], GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glCreateQueries(GL_TIMESTAMP, 2, queries);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glViewport(0, 0, Screen_width, Screen_Height);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		shader.use();
+		shader.setInt("ourTexture", 0);
+		shader.setVec2("viewportSize", float(Screen_width), float(Screen_Height));
+		sheet.bind(0);
+		glBindVertexArray(vao);
+
+		double pixels = double(Screen_width) * Screen_Height * layers;
+		std::cout << imagePath << ", " << layers << " full screen layers at " << Screen_width << "x" << Screen_Height << ", GPU time per frame" << std::endl;
+		for (float texelsPerPixel : { 1.0f, 4.0f, 16.0f, 64.0f })
+		{
+			// GPU time from the timestamps, and wall time up to glFinish for drivers (software ones)
+			// that stamp at submission rather than when the work is done
+			double gpuMs[2], wallMs[2];
+			shader.setFloat("texelsPerPixel", texelsPerPixel);
+			for (int mode = 0; mode < 2; mode++)
+			{
+				glBindSampler(0, samplers[mode]);
+				GLuint64 total = 0;
+				double wall = 0.0;
+				// frame -1 warms up and is not counted
+				for (int frame = -1; frame < frames; frame++)
+				{
+					Clock clock;
+					glQueryCounter(queries[0], GL_TIMESTAMP);
+					for (int layer = 0; layer < layers; layer++)
+						glDrawArrays(GL_TRIANGLES, 0, 6);
+					glQueryCounter(queries[1], GL_TIMESTAMP);
+					glFinish();
+					GLuint64 begin = 0, end = 0;
+					glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &begin);
+					glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &end);
+					if (frame >= 0)
+					{
+						total += end - begin;
+						wall += clock.seconds() * 1000.0;
+					}
+				}
+				gpuMs[mode] = double(total) * 1e-6 / frames;
+				wallMs[mode] = wall / frames;
+			}
+			std::cout << texelsPerPixel << " texels per pixel: mipmapped " << gpuMs[0] << " ms GPU, " << wallMs[0] << " ms wall ("
+				<< pixels / gpuMs[0] * 1e-6 << " Gpixels/s); level 0 only " << gpuMs[1] << " ms GPU, " << wallMs[1] << " ms wall ("
+				<< pixels / gpuMs[1] * 1e-6 << " Gpixels/s); mips " << gpuMs[1] / gpuMs[0] << "x faster on the GPU clock" << std::endl;
+		}
+
+		glBindSampler(0, 0);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteQueries(2, queries);
+		glDeleteSamplers(2, samplers);
+		glDeleteVertexArrays(1, &vao);
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteTextures(1, &target);
+		sheet.cleanUp();
+	}
+	glfwDestroyWindow(window);
+	glfwTerminate();
+}
+
+void BenchCompressedTexture(const std::string& imagePath)
+{
+	// what Texture does on the CPU before handing data to GL: decode the image, or map the .ctex and
+	// validate it and read every block once, as the upload would. The GPU's mip generation for the
+	// decoded image comes on top of its number and is not measured here.
+	const int runs = 20;
+	Clock clock;
+	size_t sourceBytes = size_t(std::filesystem::file_size(imagePath));
+	int width = 0, height = 0, channels = 0;
+	for (int i = 0; i < runs; i++)
+	{
+		unsigned char* pixels = stbi_load(imagePath.c_str(), &width, &height, &channels, 0);
+		if (!pixels)
+		{
+			std::cout << "Failed to load texture at " << imagePath << std::endl;
+			return;
+		}
+		stbi_image_free(pixels);
+	}
+	double decodeMs = clock.seconds() * 1000.0 / runs;
+	size_t texelBytes = channels == 3 ? 4 : size_t(channels); // what Texture counts, RGB8 is padded
+	size_t rawBytes = 0;
+	for (int level = 0; (width | height) >> level || level == 0; level++)
+		rawBytes += size_t(std::max(1, width >> level)) * std::max(1, height >> level) * texelBytes;
+	std::cout << imagePath << " (" << width << "x" << height << "): " << sourceBytes / 1024 << " KB on disk, "
+		<< rawBytes / 1024 << " KB in VRAM with mips, " << decodeMs << " ms to decode" << std::endl;
+
+	for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC7 })
+	{
+		std::string name = format == BlockFormat::BC1 ? "bc1" : "bc7";
+		std::string ctexPath = (std::filesystem::temp_directory_path() / ("bench-" + name + ".ctex")).string();
+		if (!TextureCompressor::compressFile(imagePath, ctexPath, format))
+			return;
+		clock = Clock();
+		size_t blockBytesTotal = 0;
+		uint32_t pageSum = 0; // one byte per 64 touched and printed, so the reads are not optimized away
+		for (int i = 0; i < runs; i++)
+		{
+			MappedFile file(ctexPath);
+			const CompressedMipLevel* levels = nullptr;
+			const CompressedTextureHeader* header = file.isOpen() ? readCompressedTexture(file, levels) : nullptr;
+			if (!header)
+			{
+				std::cout << "Failed to load compressed texture at " << ctexPath << std::endl;
+				return;
+			}
+			blockBytesTotal = 0;
+			for (uint32_t level = 0; level < header->mipCount; level++)
+			{
+				const unsigned char* data = file.data() + levels[level].offset;
+				for (uint64_t b = 0; b < levels[level].size; b += 64)
+					pageSum += data[b];
+				blockBytesTotal += size_t(levels[level].size);
+			}
+		}
+		double loadMs = clock.seconds() * 1000.0 / runs;
+		size_t fileBytes = size_t(std::filesystem::file_size(ctexPath));
+		std::cout << name << ": " << fileBytes / 1024 << " KB on disk (" << double(fileBytes) / sourceBytes << "x the source), "
+			<< blockBytesTotal / 1024 << " KB in VRAM (" << double(rawBytes) / blockBytesTotal << "x smaller), "
+			<< loadMs << " ms to map and validate (" << decodeMs / loadMs << "x faster, page sum " << pageSum << ")" << std::endl;
+		std::filesystem::remove(ctexPath);
+	}
+}
+
+void BenchTilemap(int frameCount)
+{
+	// what TilemapRenderer does on the CPU each frame, minus the GL calls: find the chunks under a
+	// 1920x1080 camera at 32 pixel tiles, rebuild the ones whose version moved and add up the rest.
+	// The camera pans diagonally and one tile under it changes every frame.
+	const glm::vec2 VIEW(60.0f, 34.0f);
+	const uint32_t FRAMES = 16; // tiles use frames 0-15
+	for (int side : { 256, 1024, 4096 })
+	{
+		Tilemap map(side, side, 1.0f);
+		for (int cy = 0; cy < map.getChunksY(); cy++)
+			for (int cx = 0; cx < map.getChunksX(); cx++)
+			{
+				uint16_t* tiles = map.chunkTiles(cx, cy);
+				for (int i = 0; i < Tilemap::CHUNK_SIZE * Tilemap::CHUNK_SIZE; i++)
+					tiles[i] = uint16_t((cx * 7 + cy * 3 + i) % 5 == 0 ? Tilemap::EMPTY : i % 16);
+				map.touchChunk(cx, cy);
+			}
+
+		std::vector<uint32_t> builtVersion(map.chunkCount(), UINT32_MAX), tileCounts(map.chunkCount(), 0);
+		std::vector<uint32_t> packed;
+		uint32_t seed = 1;
+		size_t visited = 0, rebuilt = 0, drawn = 0;
+		glm::vec2 camera = glm::vec2(float(side) * 0.5f);
+		Clock clock;
+		for (int frame = 0; frame < frameCount; frame++)
+		{
+			camera += glm::vec2(0.7f, 0.3f);
+			if (camera.x > float(side) || camera.y > float(side))
+				camera = VIEW * 0.5f;
+			seed = seed * 1664525u + 1013904223u;
+			map.set(int(camera.x) + int(seed >> 27) - 16, int(camera.y) + int((seed >> 22) & 15) - 8, uint16_t(seed & 15));
+
+			glm::ivec2 lo, hi;
+			map.chunkRange(camera - VIEW * 0.5f, camera + VIEW * 0.5f, lo, hi);
+			for (int y = lo.y; y <= hi.y; y++)
+				for (int x = lo.x; x <= hi.x; x++)
+				{
+					size_t chunk = size_t(y) * map.getChunksX() + x;
+					uint32_t version = map.chunkVersion(x, y);
+					if (builtVersion[chunk] != version)
+					{
+						tileCounts[chunk] = uint32_t(map.packChunk(x, y, FRAMES, packed));
+						builtVersion[chunk] = version;
+						rebuilt++;
+					}
+					drawn += tileCounts[chunk];
+					visited++;
+				}
+		}
+		double us = clock.seconds() * 1e6 / frameCount;
+		std::cout << side << "x" << side << " tiles (" << map.chunkCount() << " chunks): " << us << " us per frame, "
+			<< double(visited) / frameCount << " chunks and " << drawn / size_t(frameCount) << " tiles drawn, "
+			<< double(rebuilt) / frameCount << " chunk rebuilds per frame" << std::endl;
+	}
+}
+
+void BenchStream(const std::string& path, int frameCount)
+{
+	// a world of hills: sky above the surface, eight repeating rock chunks below it and a unique
+	// chunk wherever the surface passes, which is where the camera flies
+	const uint32_t SIDE = 100000;
+	auto ground = [](int x) {
+		return 50000 + int(2000.0 * std::sin(x * 0.0002) + 200.0 * std::sin(x * 0.004) + 8.0 * std::sin(x * 0.07));
+	};
+	const int CHUNK = Tilemap::CHUNK_SIZE;
+	const uint32_t FRAMES = 8; // surface layers 0-2, rock 4-7
+	if (!std::filesystem::exists(path))
+	{
+		std::vector<std::vector<uint16_t>> rock(8, std::vector<uint16_t>(TILEMAP_CHUNK_TILES));
+		for (size_t t = 0; t < rock.size(); t++)
+			for (size_t i = 0; i < TILEMAP_CHUNK_TILES; i++)
+				rock[t][i] = uint16_t((i * 7 + t * 13 + i / CHUNK * 5) % 11 == 0 ? Tilemap::EMPTY : 4 + (i + t) % 4);
+		std::vector<int> surface(SIDE + CHUNK), top(SIDE / CHUNK + 1), bottom(SIDE / CHUNK + 1);
+		for (size_t x = 0; x < surface.size(); x++)
+			surface[x] = ground(int(x));
+		for (size_t cx = 0; cx < top.size(); cx++)
+		{
+			auto column = surface.begin() + cx * CHUNK;
+			top[cx] = *std::max_element(column, column + CHUNK);
+			bottom[cx] = *std::min_element(column, column + CHUNK);
+		}
+		Clock clock;
+		bool written = writeTilemapFile(path, SIDE, SIDE, [&](uint32_t cx, uint32_t cy, uint16_t* scratch) -> const uint16_t* {
+			int y0 = int(cy) * CHUNK;
+			const std::vector<uint16_t>& below = rock[(cx * 7 + cy * 3) % rock.size()];
+			if (y0 > top[cx])
+				return nullptr;
+			if (y0 + CHUNK <= bottom[cx] - 3)
+				return below.data();
+			for (int x = 0; x < CHUNK; x++)
+				for (int y = 0; y < CHUNK; y++)
+				{
+					int depth = surface[cx * CHUNK + x] - (y0 + y);
+					size_t i = size_t(y) * CHUNK + x;
+					scratch[i] = depth < 0 ? Tilemap::EMPTY : depth < 3 ? uint16_t(depth) : below[i];
+				}
+			return scratch;
+		});
+		if (!written)
+			return;
+		std::cout << "written in " << clock.seconds() << " s" << std::endl;
+	}
+
+	// a 1920x1080 camera at 32 pixel tiles crossing the whole width at a paced 60 Hz, with the
+	// CPU side of TilemapRenderer repacking every chunk whose slot got new tiles
+	const glm::vec2 VIEW(60.0f, 34.0f);
+	const double FRAME = 1.0 / 60.0;
+	JobSystem system(std::max(2u, std::thread::hardware_concurrency()));
+	TileStreamer streamer(system, path, 1.0f, glm::vec2(0.0f), 512, 4, 64);
+	if (!streamer.isOpen())
+		return;
+	std::vector<uint32_t> builtVersion(streamer.chunkSlots(), 0), packed;
+	double totalMs = 0.0, worstMs = 0.0;
+	int missingFrames = 0, slowFrames = 0;
+	uint32_t worstMissing = 0;
+	float speed = float(SIDE) / float(frameCount);
+	Clock clock;
+	for (int frame = 0; frame < frameCount; frame++)
+	{
+		double frameStart = clock.seconds();
+		float x = float(frame) * speed;
+		glm::vec2 camera(x, float(ground(int(x))));
+		glm::vec2 viewMin = camera - VIEW * 0.5f, viewMax = camera + VIEW * 0.5f;
+		streamer.update(viewMin, viewMax);
+		glm::ivec2 lo, hi;
+		streamer.chunkRange(viewMin, viewMax, lo, hi);
+		for (int cy = lo.y; cy <= hi.y; cy++)
+			for (int cx = lo.x; cx <= hi.x; cx++)
+			{
+				uint32_t slot = streamer.chunkSlot(cx, cy);
+				if (slot != TileStreamer::NONE && builtVersion[slot] != streamer.slotVersion(slot))
+				{
+					streamer.packChunk(cx, cy, FRAMES, packed);
+					builtVersion[slot] = streamer.slotVersion(slot);
+				}
+			}
+		// skip the first frame, which finds nothing loaded by design
+		if (frame > 0 && streamer.counters().missing > 0)
+		{
+			missingFrames++;
+			worstMissing = std::max(worstMissing, streamer.counters().missing);
+		}
+		double ms = (clock.seconds() - frameStart) * 1000.0;
+		totalMs += ms;
+		worstMs = std::max(worstMs, ms);
+		if (ms > 1.0)
+			slowFrames++;
+		double wake = (frame + 1) * FRAME;
+		while (clock.seconds() < wake)
+			std::this_thread::sleep_for(std::chrono::microseconds(500));
+	}
+	const TileStreamer::Stats& stats = streamer.counters();
+	std::cout << streamer.getWidth() << "x" << streamer.getHeight() << " tiles (" << size_t(streamer.getChunksX()) * streamer.getChunksY() << " chunks), "
+		<< frameCount << " frames at " << speed * 60.0f << " tiles per second, " << system.workerCount() << " workers" << std::endl;
+	std::cout << "update + pack: " << totalMs / frameCount << " ms average, " << worstMs << " ms worst, " << slowFrames << " frames over 1 ms" << std::endl;
+	std::cout << "frames with a visible chunk not loaded: " << missingFrames << " (at most " << worstMissing << " chunks)" << std::endl;
+	std::cout << stats.loads << " loads, " << stats.evictions << " evictions, " << stats.deferred << " deferred, " << stats.failures << " corrupt, "
+		<< streamer.residentMemory() / 1024 << " KB of chunk slots" << std::endl;
+}
+
+int BenchRigidBodies(size_t boxCount)
+{
+	// stacks of ten unit boxes side by side on one static floor, a little off centre so they have
+	// something to settle; every stack is its own island
+	const int HEIGHT = 10;
+	size_t stacks = std::max<size_t>(1, (boxCount + HEIGHT - 1) / HEIGHT);
+	const float SPACING = 1.5f;
+	const int ticks = 180;
+	const float dt = float(1.0 / TICK_RATE);
+	unsigned maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+	auto addStacks = [&](RigidBodyWorld& bodies, float jitter) {
+		float width = float(stacks) * SPACING;
+		bodies.add(RigidBody::box(glm::vec2(width * 0.5f, -0.5f), glm::vec2(width * 0.5f + 1.0f, 0.5f), 0.0f));
+		uint32_t seed = 1;
+		auto random = [&seed]() {
+			seed = seed * 1664525u + 1013904223u;
+			return float(seed >> 8) / 16777216.0f;
+		};
+		for (size_t i = 0; i < boxCount; i++)
+		{
+			float x = (float(i / HEIGHT) + 0.5f) * SPACING + (random() - 0.5f) * jitter;
+			float y = float(i % HEIGHT) * 1.0f + 0.5f;
+			bodies.add(RigidBody::box(glm::vec2(x, y), glm::vec2(0.5f), 1.0f));
+		}
+	};
+	double baseline = 0.0;
+	for (unsigned workers = 1; workers <= maxWorkers; workers++)
+	{
+		JobSystem system(workers);
+		RigidBodyWorld bodies;
+		addStacks(bodies, 0.1f);
+
+		double settling = 0.0, asleep = 0.0;
+		for (int tick = 0; tick < ticks; tick++)
+		{
+			Clock clock;
+			bodies.step(dt, workers == 1 ? nullptr : &system);
+			double ms = clock.seconds() * 1000.0;
+			if (tick < 30)
+				settling += ms / 30.0;
+			else if (tick >= ticks - 30)
+				asleep += ms / 30.0;
+		}
 
-	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+		// a stack that held keeps its top box about HEIGHT units up
+		size_t toppled = 0;
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for (uint32_t id = 1; id < bodies.size(); id++)
+		{
+			const RigidBody& body = bodies.body(id);
+			if ((id - 1) % HEIGHT == HEIGHT - 1 && body.position.y < float(HEIGHT) - 1.0f)
+				toppled++;
+			for (float value : { body.position.x, body.position.y, body.angle })
+			{
+				uint32_t word;
+				std::memcpy(&word, &value, sizeof(word));
+				hash = (hash ^ word) * 0x100000001B3ull;
+			}
+		}
+		if (workers == 1)
+			baseline = settling;
+		std::cout << workers << " workers: " << settling << " ms per step settling (" << baseline / settling << "x), " << asleep << " ms once still, "
+			<< bodies.awakeCount() << " of " << boxCount << " awake, " << bodies.islandCount() << " islands, " << bodies.manifoldCount() << " manifolds, "
+			<< toppled << " of " << stacks << " stacks toppled, hash " << std::hex << hash << std::dec << std::endl;
+	}
+
+	// the same stacks perfectly aligned have nothing to settle, their contacts are exactly
+	// symmetric instead; unstable contact ids or solving one point at a time show up there as a
+	// sway that never lets the stacks sleep
+	RigidBodyWorld aligned;
+	addStacks(aligned, 0.0f);
+	const int LIMIT = int(30.0 * TICK_RATE);
+	int asleepTick = -1;
+	for (int tick = 0; tick < LIMIT && asleepTick < 0; tick++)
+	{
+		aligned.step(dt);
+		if (aligned.awakeCount() == 0)
+			asleepTick = tick + 1;
+	}
+	if (asleepTick < 0)
 	{
-		transform.position.y += playerSpeed * deltaTime;
+		std::cout << "RIGID::" << aligned.awakeCount() << " of " << boxCount << " aligned boxes still awake after " << LIMIT / TICK_RATE << " s" << std::endl;
+		return 1;
 	}
+	std::cout << "aligned stacks: all " << boxCount << " boxes asleep after " << asleepTick / TICK_RATE << " s" << std::endl;
+	return 0;
+}
 
+// snapshot of the game state for the render thread
+void WritePacket(FramePacket& packet, double tickTime, double tickSeconds, double inputTime)
+{
+	packet.reset();
+	world.forEachChunk<Transform, PreviousTransform, Sprite>([&packet](size_t count, Entity*, Transform* current, PreviousTransform* previous, Sprite* sprites) {
+		for (size_t i = 0; i < count; i++)
+		{
+			packet.previous.push_back(previous[i].value);
+			packet.current.push_back(current[i]);
+			packet.frames.push_back(sprites[i].frame);
+		}
+	});
+	packet.texts.push_back({ "Hello There", glm::vec2(0.0f, 5.0f), 5.0f, glm::vec3(0.2, 0.5f, 0.6f) });
+	packet.zoom = Zoom;
+	packet.viewportWidth = Screen_width;
+	packet.viewportHeight = Screen_Height;
+	packet.tickTime = tickTime;
+	packet.tickSeconds = tickSeconds;
+	packet.inputTime = inputTime;
+}
 
-	if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+// render thread only
+void RenderFrame(const FramePacket& packet, double now, Shader& shader, Shader& tileShader, Shader& textShader, Texture& image, const SpriteSheet& sheet)
+{
+	PROFILE_SCOPE("RenderFrame");
+	static int viewportWidth = 0, viewportHeight = 0;
+	if (packet.viewportWidth != viewportWidth || packet.viewportHeight != viewportHeight)
 	{
-		transform.position.y -= playerSpeed * deltaTime;
+		viewportWidth = packet.viewportWidth;
+		viewportHeight = packet.viewportHeight;
+		glViewport(0, 0, viewportWidth, viewportHeight);
 	}
 
+	float alpha = packet.alpha(now);
+	size_t spriteCount = std::min(packet.current.size(), transforms.size());
+	{
+		PROFILE_SCOPE("Interpolate");
+		jobs->parallelFor(0, spriteCount, 4096, [&](size_t first, size_t last) {
+			for (size_t i = first; i < last; i++)
+				transforms[i] = interpolate(packet.previous[i], packet.current[i], alpha).to_mat4();
+		});
+		std::copy(packet.frames.begin(), packet.frames.begin() + std::min(packet.frames.size(), spriteFrames.size()), spriteFrames.begin());
+	}
+
+	glClearColor(0.1f, 0.3f, 0.3f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	float left = -viewportWidth / (2.0f * packet.zoom);
+	float right = viewportWidth / (2.0f * packet.zoom);
+	float bottom = -viewportHeight / (2.0f * packet.zoom);
+	float top = viewportHeight / (2.0f * packet.zoom);
 
-	if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+	glm::mat4 view = glm::mat4(1.0f);
+	glm::mat4 projection = glm::mat4(1.0f);
+
+	projection = glm::ortho(left, right, bottom, top, -0.1f, 100.0f);
+	view = glm::translate(view, glm::vec3(0.0f, 0.0f, -3.0f));
+
+	// level tiles under the sprites, the view only translates along z so the camera rect is the ortho box
+	image.bind(0);
+	sheet.bind(3);
+	renderStats.stateChanges += 2;
 	{
-		transform.position.x -= playerSpeed * deltaTime;
+		GPU_PROFILE_SCOPE(*gpuProfiler, "Tilemap");
+		tilemapRenderer->draw(tileShader, view, projection, glm::vec2(left, bottom), glm::vec2(right, top), renderStats);
 	}
 
+	shader.use();
+	renderStats.stateChanges++;
+	renderStats.sprites += uint32_t(spriteCount);
+	shader.setMat4("projection", projection);
+	shader.setMat4("view", view);
+
+	{
+		PROFILE_SCOPE("Transform upload");
+		GPU_PROFILE_SCOPE(*gpuProfiler, "Transform upload");
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, SSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, vertices.size() * sizeof(Vertex), NULL, GL_DYNAMIC_DRAW);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, transforms.size() * sizeof(glm::mat4), transforms.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		// frame indices are packed two per uint in the shader, round the upload up to whole uints
+		size_t frameBytes = ((spriteFrames.size() + 1) / 2) * sizeof(uint32_t);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, FrameSSBO);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, frameBytes, NULL, GL_DYNAMIC_DRAW);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, spriteFrames.size() * sizeof(uint16_t), spriteFrames.data());
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), NULL, GL_DYNAMIC_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		renderStats.stateChanges += 6;
+		renderStats.bytesUploaded += transforms.size() * sizeof(glm::mat4) + spriteFrames.size() * sizeof(uint16_t) + vertices.size() * sizeof(Vertex);
+	}
 
-	if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
 	{
-		transform.position.x += playerSpeed * deltaTime;
+		PROFILE_SCOPE("Sprite draw");
+		GPU_PROFILE_SCOPE(*gpuProfiler, "Sprite draw");
+		glBindVertexArray(VAO);
+		glDrawArrays(GL_TRIANGLES, 0, vertices.size());
+		renderStats.stateChanges++;
+		renderStats.drawCalls++;
 	}
 
-	transforms[0] = transform.to_mat4();
+	left = 0;
+	right = viewportWidth;
+	bottom = 0;
+	top = viewportHeight;
+	projection = glm::ortho(left, right, bottom, top, -1.0f, 1.0f);
+
+	PROFILE_SCOPE("RenderText");
+	GPU_PROFILE_SCOPE(*gpuProfiler, "RenderText");
+	textShader.use();
+	textShader.setMat4("projection", projection);
+	for (const TextRun& run : packet.texts)
+		RenderText(textShader, run.text, run.position.x, run.position.y, run.scale, run.color);
 }
 
 void RenderText(Shader& shader, std::string text, float x, float y, float scale, glm::vec3 color)
@@ -370,6 +1930,7 @@ void RenderText(Shader& shader, std::string text, float x, float y, float scale,
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D_ARRAY, textureArray);
 	glBindVertexArray(TVAO);
+	renderStats.stateChanges += 3;
 	//glBindBuffer(GL_ARRAY_BUFFER, TVBO);
 
 	int workingIndex = 0;
@@ -394,6 +1955,7 @@ void RenderText(Shader& shader, std::string text, float x, float y, float scale,
 
 			T[workingIndex] = glm::translate(glm::mat4(1.0f), glm::vec3(xpos, ypos, 0)) * glm::scale(glm::mat4(1.0f), glm::vec3(256 * scale, 256 * scale, 0));
 			letterMap[workingIndex] = ch.TextureID;
+			renderStats.glyphs++;
 
 			// now advance cursors for next glyph (note that advance is number of 1/64 pixels)
 			x += (ch.Advance >> 6) * scale; // bitshift by 6 to get value in pixels (2^6 = 64 (divide amount of 1/64th pixels by 64 to get amount of pixels))
@@ -420,6 +1982,8 @@ void TextRenderCall(int length, GLuint shader)
 		glUniformMatrix4fv(glGetUniformLocation(shader, "transforms"), length, GL_FALSE, &T[0][0][0]);
 		glUniform1iv(glGetUniformLocation(shader, "letterMap"), length, &letterMap[0]);
 		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, length);
+		renderStats.drawCalls++;
+		renderStats.bytesUploaded += length * (sizeof(glm::mat4) + sizeof(int));
 	}
 
 }
@@ -428,6 +1992,8 @@ void glDebugOutput(GLenum source, GLenum type, unsigned int id, GLenum severity,
 {
 	// ignore non-significant error/warning codes
 	if (id == 131169 || id == 131185 || id == 131218 || id == 131204) return;
+	// profiler debug groups
+	if (type == GL_DEBUG_TYPE_PUSH_GROUP || type == GL_DEBUG_TYPE_POP_GROUP) return;
 
 	std::cout << "---------------" << std::endl;
 	std::cout << "Debug message (" << id << "): " << message << std::endl;
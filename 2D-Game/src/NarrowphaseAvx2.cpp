@@ -0,0 +1,32 @@
+// The narrowphase lane loops with AVX2 lanes, the only code built with /arch:AVX2 (x64 only, set on
+// this file in the project). Narrowphase calls them after checking the CPU, so the rest of the
+// program keeps running on CPUs without AVX2.
+#include "Physics/Narrowphase.hpp"
+
+#if defined(__AVX2__)
+const int Narrowphase::AVX2_LANES = Simd::Float8::WIDTH;
+
+size_t Narrowphase::testAvx2(const BoxKernel&, const Rows& f, const ColliderPair* pairs, size_t n, Contact* written) {
+    return lanes<Simd::Float8, BoxKernel>(f, pairs, n, written);
+}
+
+size_t Narrowphase::testAvx2(const CircleKernel&, const Rows& f, const ColliderPair* pairs, size_t n, Contact* written) {
+    return lanes<Simd::Float8, CircleKernel>(f, pairs, n, written);
+}
+
+size_t Narrowphase::testAvx2(const CircleBoxKernel&, const Rows& f, const ColliderPair* pairs, size_t n, Contact* written) {
+    return lanes<Simd::Float8, CircleBoxKernel>(f, pairs, n, written);
+}
+
+size_t Narrowphase::testAvx2(const ObbKernel&, const Rows& f, const ColliderPair* pairs, size_t n, Contact* written) {
+    return lanes<Simd::Float8, ObbKernel>(f, pairs, n, written);
+}
+#else
+// built without AVX2 (32 bit): AVX2_LANES keeps collide() on the scalar loops and these are never called
+const int Narrowphase::AVX2_LANES = 1;
+
+size_t Narrowphase::testAvx2(const BoxKernel&, const Rows&, const ColliderPair*, size_t, Contact*) { return 0; }
+size_t Narrowphase::testAvx2(const CircleKernel&, const Rows&, const ColliderPair*, size_t, Contact*) { return 0; }
+size_t Narrowphase::testAvx2(const CircleBoxKernel&, const Rows&, const ColliderPair*, size_t, Contact*) { return 0; }
+size_t Narrowphase::testAvx2(const ObbKernel&, const Rows&, const ColliderPair*, size_t, Contact*) { return 0; }
+#endif
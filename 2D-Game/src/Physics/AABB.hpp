@@ -0,0 +1,50 @@
+#pragma once
+#include <glm/glm.hpp>
+
+struct AABB {
+    glm::vec2 min = glm::vec2(0.0f);
+    glm::vec2 max = glm::vec2(0.0f);
+
+    static AABB fromCenter(const glm::vec2& center, const glm::vec2& halfExtents) {
+        return { center - halfExtents, center + halfExtents };
+    }
+
+    glm::vec2 center() const {
+        return (min + max) * 0.5f;
+    }
+
+    glm::vec2 size() const {
+        return max - min;
+    }
+
+    // 2D stand-in for surface area in the tree's insertion cost
+    float perimeter() const {
+        return 2.0f * ((max.x - min.x) + (max.y - min.y));
+    }
+
+    static AABB merge(const AABB& a, const AABB& b) {
+        return { glm::min(a.min, b.min), glm::max(a.max, b.max) };
+    }
+
+    bool overlaps(const AABB& other) const {
+        return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y;
+    }
+
+    bool contains(const glm::vec2& point) const {
+        return point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y;
+    }
+
+    bool contains(const AABB& other) const {
+        return other.min.x >= min.x && other.max.x <= max.x && other.min.y >= min.y && other.max.y <= max.y;
+    }
+
+    // Slab test of origin + t * direction for t in [0, maxFraction], given 1 / direction with zero
+    // components replaced by a huge value. fraction is where the segment enters, 0 when it starts inside.
+    bool raycast(const glm::vec2& origin, const glm::vec2& inverseDirection, float maxFraction, float& fraction) const {
+        glm::vec2 t1 = (min - origin) * inverseDirection;
+        glm::vec2 t2 = (max - origin) * inverseDirection;
+        glm::vec2 lo = glm::min(t1, t2), hi = glm::max(t1, t2);
+        fraction = glm::max(glm::max(lo.x, lo.y), 0.0f);
+        return fraction <= glm::min(glm::min(hi.x, hi.y), maxFraction);
+    }
+};
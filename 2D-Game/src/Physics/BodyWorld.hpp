@@ -0,0 +1,206 @@
+#pragma once
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#include "Core/Fixed.hpp"
+#include "Core/Profiler.hpp"
+
+// Scalar constants written as exact ratios, so float and Fixed worlds start from the same numbers
+template<typename Real>
+Real realRatio(int32_t numerator, int32_t denominator);
+
+template<>
+inline float realRatio<float>(int32_t numerator, int32_t denominator) {
+    return float(numerator) / float(denominator);
+}
+
+template<>
+inline Fixed realRatio<Fixed>(int32_t numerator, int32_t denominator) {
+    return Fixed::fromRatio(numerator, denominator);
+}
+
+template<typename Real>
+struct Vector2 {
+    Real x, y;
+
+    Vector2 operator+(const Vector2& o) const { return { x + o.x, y + o.y }; }
+    Vector2 operator-(const Vector2& o) const { return { x - o.x, y - o.y }; }
+    Vector2 operator*(Real s) const { return { x * s, y * s }; }
+};
+
+// Boxes that move, bounce off the world bounds and push each other apart: integration, a sort
+// and sweep broadphase and sequential contact resolution. Real is float for the normal game or
+// Fixed for lockstep and replays, where the same inputs must give the same bits on every
+// machine. With Fixed nothing in step() touches floating point, and the order of every
+// operation is fixed: bodies by index, pairs by the sorted sweep, ties broken by index.
+template<typename Real>
+class BodyWorld {
+public:
+    static constexpr int ITERATIONS = 4;
+
+    struct Body {
+        Vector2<Real> position;
+        Vector2<Real> velocity;
+        Vector2<Real> halfExtents;
+        Real inverseMass; // 0 for immovable
+    };
+
+private:
+    struct Pair {
+        uint32_t a, b;
+    };
+
+    std::vector<Body> bodies;
+    std::vector<uint32_t> order; // by min x, kept between steps so insertion sort is nearly free
+    std::vector<Pair> pairs;
+    Vector2<Real> boundsMin, boundsMax;
+    Real restitution;
+
+public:
+    BodyWorld(Vector2<Real> boundsMin, Vector2<Real> boundsMax, Real restitution)
+        : boundsMin(boundsMin), boundsMax(boundsMax), restitution(restitution) {}
+
+    uint32_t add(const Body& body) {
+        bodies.push_back(body);
+        order.push_back(uint32_t(bodies.size() - 1));
+        return uint32_t(bodies.size() - 1);
+    }
+
+    const Body& body(uint32_t index) const {
+        return bodies[index];
+    }
+
+    size_t size() const {
+        return bodies.size();
+    }
+
+    // pairs found by the last step
+    size_t contactCount() const {
+        return pairs.size();
+    }
+
+    void step(Real dt) {
+        PROFILE_SCOPE("BodyWorld step");
+        integrate(dt);
+        findPairs();
+        for (int i = 0; i < ITERATIONS; i++)
+            resolve();
+    }
+
+    // FNV-1a over the bits of every position and velocity; two Fixed worlds that ever disagree
+    // disagree here on that tick
+    uint64_t stateHash() const {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (const Body& b : bodies)
+        {
+            Real values[4] = { b.position.x, b.position.y, b.velocity.x, b.velocity.y };
+            for (const Real& value : values)
+            {
+                uint32_t word;
+                static_assert(sizeof(Real) == sizeof(word), "hashed as one word per value");
+                std::memcpy(&word, &value, sizeof(word));
+                hash ^= word;
+                hash *= 0x100000001B3ull;
+            }
+        }
+        return hash;
+    }
+
+private:
+    void integrate(Real dt) {
+        using std::min;
+        using std::max;
+        for (Body& b : bodies)
+        {
+            b.position = b.position + b.velocity * dt;
+            // bounce off the bounds
+            Vector2<Real> low = boundsMin + b.halfExtents, high = boundsMax - b.halfExtents;
+            if (b.position.x < low.x || b.position.x > high.x)
+            {
+                b.position.x = min(max(b.position.x, low.x), high.x);
+                b.velocity.x = -b.velocity.x * restitution;
+            }
+            if (b.position.y < low.y || b.position.y > high.y)
+            {
+                b.position.y = min(max(b.position.y, low.y), high.y);
+                b.velocity.y = -b.velocity.y * restitution;
+            }
+        }
+    }
+
+    Real minX(uint32_t index) const {
+        return bodies[index].position.x - bodies[index].halfExtents.x;
+    }
+
+    bool before(uint32_t a, uint32_t b) const {
+        Real ma = minX(a), mb = minX(b);
+        return ma < mb || (ma == mb && a < b);
+    }
+
+    void findPairs() {
+        // insertion sort, bodies only move a little per tick
+        for (size_t i = 1; i < order.size(); i++)
+        {
+            uint32_t index = order[i];
+            size_t j = i;
+            for (; j > 0 && before(index, order[j - 1]); j--)
+                order[j] = order[j - 1];
+            order[j] = index;
+        }
+
+        pairs.clear();
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            const Body& a = bodies[order[i]];
+            Real maxX = a.position.x + a.halfExtents.x;
+            for (size_t j = i + 1; j < order.size() && minX(order[j]) <= maxX; j++)
+            {
+                const Body& b = bodies[order[j]];
+                Real dy = b.position.y - a.position.y;
+                Real reach = a.halfExtents.y + b.halfExtents.y;
+                if (dy < reach && -dy < reach)
+                    pairs.push_back({ order[i], order[j] });
+            }
+        }
+    }
+
+    void resolve() {
+        using std::abs;
+        Real zero = realRatio<Real>(0, 1), one = realRatio<Real>(1, 1);
+        for (const Pair& pair : pairs)
+        {
+            Body& a = bodies[pair.a];
+            Body& b = bodies[pair.b];
+            Real inverseSum = a.inverseMass + b.inverseMass;
+            if (inverseSum == zero)
+                continue;
+            Vector2<Real> d = b.position - a.position;
+            Real overlapX = a.halfExtents.x + b.halfExtents.x - abs(d.x);
+            Real overlapY = a.halfExtents.y + b.halfExtents.y - abs(d.y);
+            if (overlapX <= zero || overlapY <= zero)
+                continue;
+
+            // separate along the shallower axis, in proportion to the inverse masses
+            bool alongX = overlapX < overlapY;
+            Real depth = alongX ? overlapX : overlapY;
+            Real direction = (alongX ? d.x : d.y) < zero ? -one : one;
+            Vector2<Real> normal = alongX ? Vector2<Real>{ direction, zero } : Vector2<Real>{ zero, direction };
+            Real share = one / inverseSum;
+            Vector2<Real> correction = normal * (depth * share);
+            a.position = a.position - correction * a.inverseMass;
+            b.position = b.position + correction * b.inverseMass;
+
+            // bounce only when closing
+            Vector2<Real> relative = b.velocity - a.velocity;
+            Real closing = relative.x * normal.x + relative.y * normal.y;
+            if (closing >= zero)
+                continue;
+            Real impulse = -(one + restitution) * closing * share;
+            a.velocity = a.velocity - normal * (impulse * a.inverseMass);
+            b.velocity = b.velocity + normal * (impulse * b.inverseMass);
+        }
+    }
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <algorithm>
+
+#include "Physics/AABB.hpp"
+#include "Physics/Sweep.hpp"
+
+// Kinematic mover: sweeps its box along the requested displacement, stops just short of the
+// first surface and slides the rest of the way along it. At most MAX_ITERATIONS sweeps per move,
+// so a corner or a crowd costs the same as open ground. Movers run inside the fixed tick, where
+// the displacement is bounded by speed * tick, which keeps the swept area and the cost per tick
+// the same however long a frame took.
+class CharacterController {
+public:
+    static constexpr int MAX_ITERATIONS = 4;
+    static constexpr float SKIN = 1e-3f; // gap kept to surfaces so the next sweep does not start touching
+
+    struct Result {
+        glm::vec2 displacement = glm::vec2(0.0f); // what was actually applied
+        glm::vec2 normal = glm::vec2(0.0f);       // last surface slid along, zero when nothing was hit
+        int hits = 0;
+    };
+
+    // Moves box by up to delta. sweep(box, delta) returns the earliest SweepHit against everything
+    // the mover collides with, e.g. StaticGeometry::sweep combined with SpatialHash::sweep.
+    template<typename Sweep>
+    static Result move(AABB& box, glm::vec2 delta, const Sweep& sweep) {
+        Result result;
+        for (int i = 0; i < MAX_ITERATIONS; i++)
+        {
+            float length = glm::length(delta);
+            if (length < 1e-6f)
+                break;
+            SweepHit hit = sweep(box, delta);
+            if (!hit.hit())
+            {
+                translate(box, delta, result);
+                break;
+            }
+            // up to the surface minus the skin, then only the part of the rest along the surface
+            float time = std::max(hit.time - SKIN / length, 0.0f);
+            glm::vec2 step = delta * time;
+            translate(box, step, result);
+            glm::vec2 rest = delta - step;
+            delta = rest - hit.normal * glm::dot(rest, hit.normal);
+            result.normal = hit.normal;
+            result.hits++;
+        }
+        return result;
+    }
+
+private:
+    static void translate(AABB& box, const glm::vec2& step, Result& result) {
+        box.min += step;
+        box.max += step;
+        result.displacement += step;
+    }
+};
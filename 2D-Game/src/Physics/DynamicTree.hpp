@@ -0,0 +1,382 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "Physics/AABB.hpp"
+
+// Incremental bounding volume hierarchy for objects of very different sizes, where a uniform grid
+// either wastes cells on small objects or spreads large ones over hundreds of them.
+// Leaves hold fat boxes, enlarged by a margin and the predicted displacement, so an object that
+// moves a little stays inside its box and does not touch the tree. Insertion descends by the
+// perimeter increase it would cause, and every ancestor of a changed leaf tries a rotation that
+// shrinks it, which keeps the tree shallow without a full rebuild.
+// Nodes live in one pool linked by index; a proxy id is the index of its leaf and stays valid
+// until destroy().
+class DynamicTree {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+private:
+    static constexpr float DISPLACEMENT_MULTIPLIER = 2.0f;
+
+    struct Node {
+        AABB box;               // fat for leaves
+        uint32_t parent;        // next free node while on the free list
+        uint32_t child1, child2; // NONE for leaves
+        int32_t height;         // 0 for leaves, -1 while free
+        uint32_t userData;
+    };
+
+    // traversal stack on the caller's stack, spilling to the heap only for degenerate trees
+    template<typename T>
+    class Stack {
+    private:
+        static constexpr int INLINE = 128;
+        T items[INLINE];
+        std::vector<T> spill;
+        int count = 0;
+
+    public:
+        void push(const T& item) {
+            if (count < INLINE)
+                items[count] = item;
+            else
+                spill.push_back(item);
+            count++;
+        }
+
+        T pop() {
+            count--;
+            if (count < INLINE)
+                return items[count];
+            T item = spill.back();
+            spill.pop_back();
+            return item;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+    };
+
+    std::vector<Node> nodes;
+    uint32_t root = NONE;
+    uint32_t freeList = NONE;
+    uint32_t leafCount = 0;
+    float margin;
+
+public:
+    DynamicTree(float margin = 0.1f) : margin(margin) {}
+
+    // Returns the proxy id of a new leaf
+    uint32_t create(const AABB& box, uint32_t userData) {
+        uint32_t leaf = allocate();
+        nodes[leaf].box = { box.min - glm::vec2(margin), box.max + glm::vec2(margin) };
+        nodes[leaf].userData = userData;
+        insertLeaf(leaf);
+        leafCount++;
+        return leaf;
+    }
+
+    void destroy(uint32_t proxy) {
+        removeLeaf(proxy);
+        release(proxy);
+        leafCount--;
+    }
+
+    // Reinserts the leaf only when box has left its fat box; returns whether it did
+    bool move(uint32_t proxy, const AABB& box, const glm::vec2& displacement) {
+        if (nodes[proxy].box.contains(box))
+            return false;
+        removeLeaf(proxy);
+        AABB fat = { box.min - glm::vec2(margin), box.max + glm::vec2(margin) };
+        glm::vec2 d = displacement * DISPLACEMENT_MULTIPLIER;
+        (d.x < 0.0f ? fat.min.x : fat.max.x) += d.x;
+        (d.y < 0.0f ? fat.min.y : fat.max.y) += d.y;
+        nodes[proxy].box = fat;
+        insertLeaf(proxy);
+        return true;
+    }
+
+    const AABB& fatBox(uint32_t proxy) const {
+        return nodes[proxy].box;
+    }
+
+    uint32_t userData(uint32_t proxy) const {
+        return nodes[proxy].userData;
+    }
+
+    // Calls f(proxy) for every fat box overlapping box; f returns false to stop the query
+    template<typename F>
+    void query(const AABB& box, F&& f) const {
+        traverse([&box](const AABB& node) { return node.overlaps(box); }, f);
+    }
+
+    // Calls f(proxy) for every fat box containing point; f returns false to stop the query
+    template<typename F>
+    void query(const glm::vec2& point, F&& f) const {
+        traverse([&point](const AABB& node) { return node.contains(point); }, f);
+    }
+
+    // Walks the segment from origin to end, nearest boxes first. f(proxy, maxFraction) tests the
+    // object itself and returns 0 to stop, a fraction to clip the segment there, or maxFraction
+    // (or a negative value for an object to ignore) to carry on unchanged.
+    template<typename F>
+    void raycast(const glm::vec2& origin, const glm::vec2& end, F&& f) const {
+        if (root == NONE)
+            return;
+        glm::vec2 direction = end - origin;
+        glm::vec2 inverse(direction.x != 0.0f ? 1.0f / direction.x : 1e30f, direction.y != 0.0f ? 1.0f / direction.y : 1e30f);
+        float maxFraction = 1.0f;
+        float fraction;
+        if (!nodes[root].box.raycast(origin, inverse, maxFraction, fraction))
+            return;
+
+        // entry fractions ride along so a node that was clipped away after being pushed is skipped
+        struct Item {
+            uint32_t node;
+            float fraction;
+        };
+        Stack<Item> stack;
+        stack.push({ root, fraction });
+        while (!stack.empty())
+        {
+            Item item = stack.pop();
+            if (item.fraction > maxFraction)
+                continue;
+            const Node& node = nodes[item.node];
+            if (node.height == 0)
+            {
+                float result = f(item.node, maxFraction);
+                if (result == 0.0f)
+                    return;
+                if (result > 0.0f)
+                    maxFraction = std::min(maxFraction, result);
+                continue;
+            }
+            float fraction1, fraction2;
+            bool hit1 = nodes[node.child1].box.raycast(origin, inverse, maxFraction, fraction1);
+            bool hit2 = nodes[node.child2].box.raycast(origin, inverse, maxFraction, fraction2);
+            // the nearer child goes on top
+            if (hit1 && hit2 && fraction1 < fraction2)
+            {
+                stack.push({ node.child2, fraction2 });
+                stack.push({ node.child1, fraction1 });
+            }
+            else
+            {
+                if (hit1)
+                    stack.push({ node.child1, fraction1 });
+                if (hit2)
+                    stack.push({ node.child2, fraction2 });
+            }
+        }
+    }
+
+    size_t proxyCount() const {
+        return leafCount;
+    }
+
+    int height() const {
+        return root == NONE ? 0 : nodes[root].height;
+    }
+
+    // Summed perimeter of the internal nodes over the root's, lower means cheaper queries
+    float areaRatio() const {
+        if (root == NONE)
+            return 0.0f;
+        float total = 0.0f;
+        for (const Node& node : nodes)
+            if (node.height > 0)
+                total += node.box.perimeter();
+        return total / nodes[root].box.perimeter();
+    }
+
+private:
+    template<typename Test, typename F>
+    void traverse(const Test& test, F& f) const {
+        if (root == NONE)
+            return;
+        Stack<uint32_t> stack;
+        stack.push(root);
+        while (!stack.empty())
+        {
+            uint32_t index = stack.pop();
+            const Node& node = nodes[index];
+            if (!test(node.box))
+                continue;
+            if (node.height == 0)
+            {
+                if (!f(index))
+                    return;
+                continue;
+            }
+            stack.push(node.child1);
+            stack.push(node.child2);
+        }
+    }
+
+    uint32_t allocate() {
+        uint32_t index;
+        if (freeList != NONE)
+        {
+            index = freeList;
+            freeList = nodes[index].parent;
+        }
+        else
+        {
+            index = uint32_t(nodes.size());
+            nodes.push_back(Node());
+        }
+        Node& node = nodes[index];
+        node.parent = node.child1 = node.child2 = NONE;
+        node.height = 0;
+        node.userData = 0;
+        return index;
+    }
+
+    void release(uint32_t index) {
+        nodes[index].parent = freeList;
+        nodes[index].height = -1;
+        freeList = index;
+    }
+
+    void insertLeaf(uint32_t leaf) {
+        if (root == NONE)
+        {
+            root = leaf;
+            nodes[leaf].parent = NONE;
+            return;
+        }
+
+        // descend while pushing the leaf further down is cheaper than pairing it here. The cost
+        // is the perimeter the new parent adds plus what every ancestor grows by on the way.
+        const AABB leafBox = nodes[leaf].box;
+        uint32_t index = root;
+        while (nodes[index].height > 0)
+        {
+            const Node& node = nodes[index];
+            float combined = AABB::merge(node.box, leafBox).perimeter();
+            float cost = 2.0f * combined;
+            float inherited = 2.0f * (combined - node.box.perimeter());
+            float cost1 = descendCost(node.child1, leafBox) + inherited;
+            float cost2 = descendCost(node.child2, leafBox) + inherited;
+            if (cost < cost1 && cost < cost2)
+                break;
+            index = cost1 < cost2 ? node.child1 : node.child2;
+        }
+
+        uint32_t sibling = index;
+        uint32_t oldParent = nodes[sibling].parent;
+        uint32_t parent = allocate();
+        nodes[parent].parent = oldParent;
+        nodes[parent].box = AABB::merge(leafBox, nodes[sibling].box);
+        nodes[parent].height = nodes[sibling].height + 1;
+        nodes[parent].child1 = sibling;
+        nodes[parent].child2 = leaf;
+        nodes[sibling].parent = parent;
+        nodes[leaf].parent = parent;
+        if (oldParent == NONE)
+            root = parent;
+        else if (nodes[oldParent].child1 == sibling)
+            nodes[oldParent].child1 = parent;
+        else
+            nodes[oldParent].child2 = parent;
+
+        refit(oldParent);
+    }
+
+    float descendCost(uint32_t child, const AABB& leafBox) const {
+        float merged = AABB::merge(leafBox, nodes[child].box).perimeter();
+        return nodes[child].height == 0 ? merged : merged - nodes[child].box.perimeter();
+    }
+
+    void removeLeaf(uint32_t leaf) {
+        if (leaf == root)
+        {
+            root = NONE;
+            return;
+        }
+        uint32_t parent = nodes[leaf].parent;
+        uint32_t grandParent = nodes[parent].parent;
+        uint32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+        release(parent);
+        if (grandParent == NONE)
+        {
+            root = sibling;
+            nodes[sibling].parent = NONE;
+            return;
+        }
+        if (nodes[grandParent].child1 == parent)
+            nodes[grandParent].child1 = sibling;
+        else
+            nodes[grandParent].child2 = sibling;
+        nodes[sibling].parent = grandParent;
+        refit(grandParent);
+    }
+
+    // fixes boxes and heights from index up to the root, rotating where it helps
+    void refit(uint32_t index) {
+        while (index != NONE)
+        {
+            rotate(index);
+            Node& node = nodes[index];
+            node.box = AABB::merge(nodes[node.child1].box, nodes[node.child2].box);
+            node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+            index = node.parent;
+        }
+    }
+
+    // Swaps two nodes below a when that shrinks the nodes between them and a: a child with a
+    // grandchild under its sibling, or a grandchild with one across. The leaves below a stay the
+    // same, so only the swapped nodes' parents need new boxes and heights.
+    void rotate(uint32_t a) {
+        uint32_t b = nodes[a].child1, c = nodes[a].child2;
+        float bestGain = 0.0f;
+        uint32_t swapX = NONE, swapY = NONE;
+        auto consider = [&](uint32_t x, uint32_t y, float gain) {
+            if (gain > bestGain)
+            {
+                bestGain = gain;
+                swapX = x, swapY = y;
+            }
+        };
+        auto other = [this](uint32_t parent, uint32_t child) {
+            return nodes[parent].child1 == child ? nodes[parent].child2 : nodes[parent].child1;
+        };
+        for (uint32_t down : { b, c })
+        {
+            uint32_t sibling = down == b ? c : b;
+            if (nodes[sibling].height == 0)
+                continue;
+            float base = nodes[sibling].box.perimeter();
+            for (uint32_t up : { nodes[sibling].child1, nodes[sibling].child2 })
+                consider(down, up, base - AABB::merge(nodes[down].box, nodes[other(sibling, up)].box).perimeter());
+        }
+        if (nodes[b].height > 0 && nodes[c].height > 0)
+        {
+            float base = nodes[b].box.perimeter() + nodes[c].box.perimeter();
+            uint32_t d = nodes[b].child1, e = nodes[b].child2;
+            for (uint32_t y : { nodes[c].child1, nodes[c].child2 })
+                consider(d, y, base - AABB::merge(nodes[y].box, nodes[e].box).perimeter() - AABB::merge(nodes[d].box, nodes[other(c, y)].box).perimeter());
+        }
+        if (swapX == NONE)
+            return;
+
+        uint32_t parentX = nodes[swapX].parent, parentY = nodes[swapY].parent;
+        (nodes[parentX].child1 == swapX ? nodes[parentX].child1 : nodes[parentX].child2) = swapY;
+        (nodes[parentY].child1 == swapY ? nodes[parentY].child1 : nodes[parentY].child2) = swapX;
+        nodes[swapX].parent = parentY;
+        nodes[swapY].parent = parentX;
+        for (uint32_t parent : { parentX, parentY })
+            if (parent != a)
+            {
+                Node& node = nodes[parent];
+                node.box = AABB::merge(nodes[node.child1].box, nodes[node.child2].box);
+                node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+            }
+    }
+};
@@ -0,0 +1,198 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#include "Physics/Shapes.hpp"
+
+// One point of a contact manifold. feature names the reference face, the incident edge and which
+// end of that edge made it, so the next step can find the same point again and start from the
+// impulses it ended with (warm starting).
+struct ManifoldPoint {
+    glm::vec2 position = glm::vec2(0.0f);
+    float separation = 0.0f; // negative when penetrating
+    uint32_t feature = 0;
+
+    float normalImpulse = 0.0f;
+    float tangentImpulse = 0.0f;
+
+    // solver scratch, filled every step
+    glm::vec2 anchorA = glm::vec2(0.0f), anchorB = glm::vec2(0.0f);
+    float normalMass = 0.0f, tangentMass = 0.0f, bias = 0.0f;
+};
+
+// Up to two contact points between bodies a and b, normal pointing from a to b
+struct Manifold {
+    uint32_t a = 0, b = 0;
+    glm::vec2 normal = glm::vec2(0.0f);
+    float friction = 0.0f;
+    int pointCount = 0;
+    ManifoldPoint points[2];
+
+    // solver scratch: with two points, their normal constraints as one 2x2 system and its inverse
+    glm::mat2 normalK = glm::mat2(0.0f), normalKInverse = glm::mat2(0.0f);
+    bool blockSolve = false;
+
+    uint64_t key() const {
+        return uint64_t(a) << 32 | b;
+    }
+};
+
+// Box against box by clipping (Catto, Box2D Lite): the face of least penetration is the reference,
+// the most anti-parallel edge of the other box is clipped against the reference face's side
+// planes, and whatever is left below the reference face becomes the points. An end of the incident
+// edge that is clipped stays the same point with the same feature, as in Box2D v3: in a perfectly
+// aligned stack the corners sit exactly on the side planes, and ids that depended on which side of
+// them rounding put a corner would change every step and throw the warm start away.
+// Returns false when the boxes do not overlap.
+class BoxCollision {
+public:
+    static bool collide(const OBB& a, const OBB& b, Manifold& manifold) {
+        glm::mat2 rotationA(a.axis, glm::vec2(-a.axis.y, a.axis.x));
+        glm::mat2 rotationB(b.axis, glm::vec2(-b.axis.y, b.axis.x));
+        glm::mat2 transposeA = glm::transpose(rotationA), transposeB = glm::transpose(rotationB);
+        glm::vec2 offset = b.center - a.center;
+        glm::vec2 offsetA = transposeA * offset, offsetB = transposeB * offset;
+        glm::mat2 c = transposeA * rotationB;
+        glm::mat2 absC(glm::abs(c[0]), glm::abs(c[1]));
+        glm::mat2 absCT = glm::transpose(absC);
+
+        glm::vec2 faceA = glm::abs(offsetA) - a.halfExtents - absC * b.halfExtents;
+        if (faceA.x > 0.0f || faceA.y > 0.0f)
+            return false;
+        glm::vec2 faceB = glm::abs(offsetB) - absCT * a.halfExtents - b.halfExtents;
+        if (faceB.x > 0.0f || faceB.y > 0.0f)
+            return false;
+
+        // prefer the faces of a, then x, so the choice does not flicker between nearly equal axes
+        const float RELATIVE_TOLERANCE = 0.95f, ABSOLUTE_TOLERANCE = 0.01f;
+        enum Axis { FACE_A_X, FACE_A_Y, FACE_B_X, FACE_B_Y } axis = FACE_A_X;
+        float separation = faceA.x;
+        glm::vec2 normal = offsetA.x > 0.0f ? rotationA[0] : -rotationA[0];
+        if (faceA.y > RELATIVE_TOLERANCE * separation + ABSOLUTE_TOLERANCE * a.halfExtents.y)
+        {
+            axis = FACE_A_Y;
+            separation = faceA.y;
+            normal = offsetA.y > 0.0f ? rotationA[1] : -rotationA[1];
+        }
+        if (faceB.x > RELATIVE_TOLERANCE * separation + ABSOLUTE_TOLERANCE * b.halfExtents.x)
+        {
+            axis = FACE_B_X;
+            separation = faceB.x;
+            normal = offsetB.x > 0.0f ? rotationB[0] : -rotationB[0];
+        }
+        if (faceB.y > RELATIVE_TOLERANCE * separation + ABSOLUTE_TOLERANCE * b.halfExtents.y)
+        {
+            axis = FACE_B_Y;
+            separation = faceB.y;
+            normal = offsetB.y > 0.0f ? rotationB[1] : -rotationB[1];
+        }
+
+        // the reference face (0 to 3 counter-clockwise from +x, like the edges) and its side planes
+        glm::vec2 frontNormal, sideNormal;
+        float front, negativeSide, positiveSide;
+        bool referenceA = axis == FACE_A_X || axis == FACE_A_Y;
+        const OBB& reference = referenceA ? a : b;
+        const glm::mat2& referenceRotation = referenceA ? rotationA : rotationB;
+        frontNormal = referenceA ? normal : -normal;
+        uint32_t referenceFace;
+        if (axis == FACE_A_X || axis == FACE_B_X)
+        {
+            front = glm::dot(reference.center, frontNormal) + reference.halfExtents.x;
+            sideNormal = referenceRotation[1];
+            float side = glm::dot(reference.center, sideNormal);
+            negativeSide = -side + reference.halfExtents.y;
+            positiveSide = side + reference.halfExtents.y;
+            referenceFace = glm::dot(frontNormal, referenceRotation[0]) > 0.0f ? 0 : 2;
+        }
+        else
+        {
+            front = glm::dot(reference.center, frontNormal) + reference.halfExtents.y;
+            sideNormal = referenceRotation[0];
+            float side = glm::dot(reference.center, sideNormal);
+            negativeSide = -side + reference.halfExtents.x;
+            positiveSide = side + reference.halfExtents.x;
+            referenceFace = glm::dot(frontNormal, referenceRotation[1]) > 0.0f ? 1 : 3;
+        }
+        glm::vec2 incident[2];
+        uint32_t incidentFace = referenceA ? incidentEdge(incident, b, rotationB, frontNormal) : incidentEdge(incident, a, rotationA, frontNormal);
+
+        if (!clipSegment(incident, -sideNormal, negativeSide) || !clipSegment(incident, sideNormal, positiveSide))
+            return false;
+
+        manifold.normal = normal;
+        manifold.pointCount = 0;
+        for (uint32_t end = 0; end < 2; end++)
+        {
+            float depth = glm::dot(frontNormal, incident[end]) - front;
+            if (depth > 0.0f)
+                continue;
+            ManifoldPoint& point = manifold.points[manifold.pointCount++];
+            point = ManifoldPoint();
+            point.separation = depth;
+            // onto the reference face
+            point.position = incident[end] - depth * frontNormal;
+            point.feature = uint32_t(referenceA) << 5 | referenceFace << 3 | incidentFace << 1 | end;
+        }
+        return manifold.pointCount > 0;
+    }
+
+private:
+    // The edge of box whose outward normal is most opposed to the reference normal, in world space,
+    // counter-clockwise; returns its index, 0 to 3 counter-clockwise from +x
+    static uint32_t incidentEdge(glm::vec2 out[2], const OBB& box, const glm::mat2& rotation, const glm::vec2& referenceNormal) {
+        glm::vec2 n = -(glm::transpose(rotation) * referenceNormal);
+        glm::vec2 h = box.halfExtents;
+        uint32_t edge;
+        if (std::abs(n.x) > std::abs(n.y))
+        {
+            if (n.x > 0.0f)
+            {
+                out[0] = glm::vec2(h.x, -h.y);
+                out[1] = glm::vec2(h.x, h.y);
+                edge = 0;
+            }
+            else
+            {
+                out[0] = glm::vec2(-h.x, h.y);
+                out[1] = glm::vec2(-h.x, -h.y);
+                edge = 2;
+            }
+        }
+        else
+        {
+            if (n.y > 0.0f)
+            {
+                out[0] = glm::vec2(h.x, h.y);
+                out[1] = glm::vec2(-h.x, h.y);
+                edge = 1;
+            }
+            else
+            {
+                out[0] = glm::vec2(-h.x, -h.y);
+                out[1] = glm::vec2(h.x, -h.y);
+                edge = 3;
+            }
+        }
+        out[0] = box.center + rotation * out[0];
+        out[1] = box.center + rotation * out[1];
+        return edge;
+    }
+
+    // Keeps the part of the segment behind the plane dot(normal, v) = offset. An end in front of the
+    // plane moves onto it and keeps its slot. False when less than a segment is left.
+    static bool clipSegment(glm::vec2 segment[2], const glm::vec2& normal, float offset) {
+        float distance0 = glm::dot(normal, segment[0]) - offset;
+        float distance1 = glm::dot(normal, segment[1]) - offset;
+        if (distance0 * distance1 >= 0.0f && (distance0 > 0.0f || distance1 > 0.0f))
+            return false;
+        glm::vec2 crossing = segment[0] + distance0 / (distance0 - distance1) * (segment[1] - segment[0]);
+        if (distance0 > 0.0f)
+            segment[0] = crossing;
+        else if (distance1 > 0.0f)
+            segment[1] = crossing;
+        return true;
+    }
+};
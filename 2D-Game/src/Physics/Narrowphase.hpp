@@ -0,0 +1,355 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+
+#include "Physics/AABB.hpp"
+#include "Physics/Shapes.hpp"
+#include "Core/Simd.hpp"
+#include "Core/Profiler.hpp"
+
+// Penetration between two colliders, normal pointing from a to b
+struct Contact {
+    uint32_t a, b;
+    glm::vec2 normal;
+    float depth;
+};
+
+// contacts[0, used) are the contacts, the rest is room that only grows, so writing a batch
+// straight into the buffer does not clear its slots first every time
+class ContactBuffer {
+private:
+    std::vector<Contact> contacts;
+    size_t used = 0;
+
+public:
+    void clear() {
+        used = 0;
+    }
+
+    void reserve(size_t count) {
+        if (count > contacts.size())
+            contacts.resize(count);
+    }
+
+    void add(const Contact& contact) {
+        prepare(1)[0] = contact;
+        used++;
+    }
+
+    // Room for up to count contacts written straight into the buffer, then commit() how many were
+    Contact* prepare(size_t count) {
+        if (used + count > contacts.size())
+            contacts.resize(std::max(contacts.size() * 2, used + count));
+        return contacts.data() + used;
+    }
+
+    void commit(size_t count) {
+        used += count;
+    }
+
+    size_t size() const {
+        return used;
+    }
+
+    const Contact& operator[](size_t i) const {
+        return contacts[i];
+    }
+
+    const Contact* begin() const {
+        return contacts.data();
+    }
+
+    const Contact* end() const {
+        return contacts.data() + used;
+    }
+};
+
+// Exact tests for broadphase pairs, one shape combination per call. Pairs are gathered BATCH at a
+// time into structure-of-arrays scratch, then a kernel tests L::WIDTH pairs per step and only
+// the lanes that hit are written to the contact buffer. The kernels are templates over the lane
+// type, so the AVX2 lanes and the scalar fallback run the same arithmetic.
+// Only NarrowphaseAvx2.cpp is built with AVX2. collide() runs its Float8 lane loops when the CPU
+// has AVX2 and the scalar ones otherwise; collide<Simd::Scalar>() always takes the scalar path.
+class Narrowphase {
+private:
+    static constexpr size_t BATCH = 256;
+    static constexpr int FIELDS = 12;
+    using Rows = float[FIELDS][BATCH + 8];
+
+    // one row per gathered float, padded so the last step can read a full vector
+    float soa[FIELDS][BATCH + 8] = {};
+    bool avx2 = AVX2_LANES > 1 && Simd::hasAvx2();
+
+public:
+    // lanes of collide() on this CPU
+    int wideLanes() const {
+        return avx2 ? AVX2_LANES : 1;
+    }
+
+    // a and b index boxes
+    void collide(const AABB* boxes, const ColliderPair* pairs, size_t count, ContactBuffer& out) {
+        avx2 ? collide<Avx2>(boxes, pairs, count, out) : collide<Simd::Scalar>(boxes, pairs, count, out);
+    }
+
+    // a and b index circles
+    void collide(const Circle* circles, const ColliderPair* pairs, size_t count, ContactBuffer& out) {
+        avx2 ? collide<Avx2>(circles, pairs, count, out) : collide<Simd::Scalar>(circles, pairs, count, out);
+    }
+
+    // a indexes circles, b indexes boxes
+    void collide(const Circle* circles, const AABB* boxes, const ColliderPair* pairs, size_t count, ContactBuffer& out) {
+        avx2 ? collide<Avx2>(circles, boxes, pairs, count, out) : collide<Simd::Scalar>(circles, boxes, pairs, count, out);
+    }
+
+    // a and b index oriented boxes
+    void collide(const OBB* obbs, const ColliderPair* pairs, size_t count, ContactBuffer& out) {
+        avx2 ? collide<Avx2>(obbs, pairs, count, out) : collide<Simd::Scalar>(obbs, pairs, count, out);
+    }
+
+    template<typename L>
+    void collide(const AABB* boxes, const ColliderPair* pairs, size_t count, ContactBuffer& out) {
+        PROFILE_SCOPE("Narrowphase boxes");
+        run<L, BoxKernel>(pairs, count, out, [boxes](const ColliderPair& pair) {
+            SIMD_PREFETCH(boxes + pair.a);
+            SIMD_PREFETCH(boxes + pair.b);
+        }, [boxes](Rows& f, size_t i, const ColliderPair& pair) {
+            const AABB& a = boxes[pair.a];
+            const AABB& b = boxes[pair.b];
+            f[0][i] = a.min.x, f[1][i] = a.min.y, f[2][i] = a.max.x, f[3][i] = a.max.y;
+            f[4][i] = b.min.x, f[5][i] = b.min.y, f[6][i] = b.max.x, f[7][i] = b.max.y;
+        });
+    }
+
+    template<typename L>
+    void collide(const Circle* circles, const ColliderPair* pairs, size_t count, ContactBuffer& out) {
+        PROFILE_SCOPE("Narrowphase circles");
+        run<L, CircleKernel>(pairs, count, out, [circles](const ColliderPair& pair) {
+            SIMD_PREFETCH(circles + pair.a);
+            SIMD_PREFETCH(circles + pair.b);
+        }, [circles](Rows& f, size_t i, const ColliderPair& pair) {
+            const Circle& a = circles[pair.a];
+            const Circle& b = circles[pair.b];
+            f[0][i] = a.center.x, f[1][i] = a.center.y, f[2][i] = a.radius;
+            f[3][i] = b.center.x, f[4][i] = b.center.y, f[5][i] = b.radius;
+        });
+    }
+
+    template<typename L>
+    void collide(const Circle* circles, const AABB* boxes, const ColliderPair* pairs, size_t count, ContactBuffer& out) {
+        PROFILE_SCOPE("Narrowphase circle boxes");
+        run<L, CircleBoxKernel>(pairs, count, out, [circles, boxes](const ColliderPair& pair) {
+            SIMD_PREFETCH(circles + pair.a);
+            SIMD_PREFETCH(boxes + pair.b);
+        }, [circles, boxes](Rows& f, size_t i, const ColliderPair& pair) {
+            const Circle& a = circles[pair.a];
+            const AABB& b = boxes[pair.b];
+            f[0][i] = a.center.x, f[1][i] = a.center.y, f[2][i] = a.radius;
+            f[3][i] = b.min.x, f[4][i] = b.min.y, f[5][i] = b.max.x, f[6][i] = b.max.y;
+        });
+    }
+
+    template<typename L>
+    void collide(const OBB* obbs, const ColliderPair* pairs, size_t count, ContactBuffer& out) {
+        PROFILE_SCOPE("Narrowphase oriented boxes");
+        run<L, ObbKernel>(pairs, count, out, [obbs](const ColliderPair& pair) {
+            SIMD_PREFETCH(obbs + pair.a);
+            SIMD_PREFETCH(obbs + pair.b);
+        }, [obbs](Rows& f, size_t i, const ColliderPair& pair) {
+            const OBB& a = obbs[pair.a];
+            const OBB& b = obbs[pair.b];
+            f[0][i] = a.center.x, f[1][i] = a.center.y, f[2][i] = a.halfExtents.x, f[3][i] = a.halfExtents.y, f[4][i] = a.axis.x, f[5][i] = a.axis.y;
+            f[6][i] = b.center.x, f[7][i] = b.center.y, f[8][i] = b.halfExtents.x, f[9][i] = b.halfExtents.y, f[10][i] = b.axis.x, f[11][i] = b.axis.y;
+        });
+    }
+
+private:
+    // Kernels read one step of lanes from the gathered rows and return the mask of lanes that hit
+    struct BoxKernel {
+        template<typename L>
+        static auto test(const Rows& f, size_t i, L& nx, L& ny, L& depth) {
+            L aMinX = L::load(f[0] + i), aMinY = L::load(f[1] + i), aMaxX = L::load(f[2] + i), aMaxY = L::load(f[3] + i);
+            L bMinX = L::load(f[4] + i), bMinY = L::load(f[5] + i), bMaxX = L::load(f[6] + i), bMaxY = L::load(f[7] + i);
+            L zero = L::set(0.0f), one = L::set(1.0f), minusOne = L::set(-1.0f);
+            // half sizes against the center offset, so a box nested in the other along an axis
+            // still reports how far it has to move to get out
+            L half = L::set(0.5f);
+            L dx = ((bMinX + bMaxX) - (aMinX + aMaxX)) * half;
+            L dy = ((bMinY + bMaxY) - (aMinY + aMaxY)) * half;
+            L overlapX = ((aMaxX - aMinX) + (bMaxX - bMinX)) * half - abs(dx);
+            L overlapY = ((aMaxY - aMinY) + (bMaxY - bMinY)) * half - abs(dy);
+            auto alongX = overlapX < overlapY;
+            nx = select(alongX, select(dx < zero, minusOne, one), zero);
+            ny = select(alongX, zero, select(dy < zero, minusOne, one));
+            depth = select(alongX, overlapX, overlapY);
+            return (overlapX >= zero) & (overlapY >= zero);
+        }
+    };
+
+    struct CircleKernel {
+        template<typename L>
+        static auto test(const Rows& f, size_t i, L& nx, L& ny, L& depth) {
+            L dx = L::load(f[3] + i) - L::load(f[0] + i);
+            L dy = L::load(f[4] + i) - L::load(f[1] + i);
+            L radius = L::load(f[2] + i) + L::load(f[5] + i);
+            L distanceSquared = dx * dx + dy * dy;
+            L distance = sqrt(distanceSquared);
+            // concentric circles get an arbitrary but consistent normal
+            auto apart = distance > L::set(1e-6f);
+            L inverse = L::set(1.0f) / select(apart, distance, L::set(1.0f));
+            nx = select(apart, dx * inverse, L::set(1.0f));
+            ny = select(apart, dy * inverse, L::set(0.0f));
+            depth = radius - distance;
+            return distanceSquared <= radius * radius;
+        }
+    };
+
+    struct CircleBoxKernel {
+        template<typename L>
+        static auto test(const Rows& f, size_t i, L& nx, L& ny, L& depth) {
+            L cx = L::load(f[0] + i), cy = L::load(f[1] + i), radius = L::load(f[2] + i);
+            L minX = L::load(f[3] + i), minY = L::load(f[4] + i), maxX = L::load(f[5] + i), maxY = L::load(f[6] + i);
+            L zero = L::set(0.0f), one = L::set(1.0f), minusOne = L::set(-1.0f);
+            // closest point of the box to the center
+            L dx = min(max(cx, minX), maxX) - cx;
+            L dy = min(max(cy, minY), maxY) - cy;
+            L distanceSquared = dx * dx + dy * dy;
+            L distance = sqrt(distanceSquared);
+            auto outside = distance > L::set(1e-6f);
+            L inverse = one / select(outside, distance, one);
+
+            // center inside the box: push the circle out through the nearest face
+            L left = cx - minX, right = maxX - cx, bottom = cy - minY, top = maxY - cy;
+            L faceX = min(left, right), faceY = min(bottom, top);
+            auto alongX = faceX < faceY;
+            L insideX = select(alongX, select(left < right, one, minusOne), zero);
+            L insideY = select(alongX, zero, select(bottom < top, one, minusOne));
+
+            nx = select(outside, dx * inverse, insideX);
+            ny = select(outside, dy * inverse, insideY);
+            depth = select(outside, radius - distance, radius + select(alongX, faceX, faceY));
+            return distanceSquared <= radius * radius;
+        }
+    };
+
+    // Separating axis test over both boxes' axes; in 2D the four projections only need the
+    // cosine and sine of the relative angle
+    struct ObbKernel {
+        template<typename L>
+        static auto test(const Rows& f, size_t i, L& nx, L& ny, L& depth) {
+            L aHalfX = L::load(f[2] + i), aHalfY = L::load(f[3] + i), aCos = L::load(f[4] + i), aSin = L::load(f[5] + i);
+            L bHalfX = L::load(f[8] + i), bHalfY = L::load(f[9] + i), bCos = L::load(f[10] + i), bSin = L::load(f[11] + i);
+            L dx = L::load(f[6] + i) - L::load(f[0] + i);
+            L dy = L::load(f[7] + i) - L::load(f[1] + i);
+            L zero = L::set(0.0f), one = L::set(1.0f), minusOne = L::set(-1.0f);
+
+            L c = abs(aCos * bCos + aSin * bSin);
+            L s = abs(aCos * bSin - aSin * bCos);
+            // offset along each axis: a's x and y, then b's x and y
+            L offsets[4] = { dx * aCos + dy * aSin, dy * aCos - dx * aSin, dx * bCos + dy * bSin, dy * bCos - dx * bSin };
+            L axesX[4] = { aCos, zero - aSin, bCos, zero - bSin };
+            L axesY[4] = { aSin, aCos, bSin, bCos };
+            L overlaps[4] = {
+                aHalfX + c * bHalfX + s * bHalfY - abs(offsets[0]),
+                aHalfY + s * bHalfX + c * bHalfY - abs(offsets[1]),
+                bHalfX + c * aHalfX + s * aHalfY - abs(offsets[2]),
+                bHalfY + s * aHalfX + c * aHalfY - abs(offsets[3]),
+            };
+
+            // the axis of least overlap, flipped to point from a to b
+            depth = overlaps[0];
+            L axisX = axesX[0], axisY = axesY[0], offset = offsets[0];
+            auto hit = overlaps[0] >= zero;
+            for (int k = 1; k < 4; k++)
+            {
+                hit = hit & (overlaps[k] >= zero);
+                auto smaller = overlaps[k] < depth;
+                depth = select(smaller, overlaps[k], depth);
+                axisX = select(smaller, axesX[k], axisX);
+                axisY = select(smaller, axesY[k], axisY);
+                offset = select(smaller, offsets[k], offset);
+            }
+            L sign = select(offset < zero, minusOne, one);
+            nx = axisX * sign;
+            ny = axisY * sign;
+            return hit;
+        }
+    };
+
+    // tag for the lane loops defined in NarrowphaseAvx2.cpp
+    struct Avx2 {};
+
+    // AVX2_LANES is 1 when NarrowphaseAvx2.cpp was built without AVX2, and the loops are then never called
+    static const int AVX2_LANES;
+    static size_t testAvx2(const BoxKernel&, const Rows& f, const ColliderPair* pairs, size_t n, Contact* written);
+    static size_t testAvx2(const CircleKernel&, const Rows& f, const ColliderPair* pairs, size_t n, Contact* written);
+    static size_t testAvx2(const CircleBoxKernel&, const Rows& f, const ColliderPair* pairs, size_t n, Contact* written);
+    static size_t testAvx2(const ObbKernel&, const Rows& f, const ColliderPair* pairs, size_t n, Contact* written);
+
+    template<typename L, typename Kernel>
+    static size_t test(const Rows& f, const ColliderPair* pairs, size_t n, Contact* written) {
+        if constexpr (std::is_same<L, Avx2>::value)
+            return testAvx2(Kernel(), f, pairs, n, written);
+        else
+            return lanes<L, Kernel>(f, pairs, n, written);
+    }
+
+    // Tests n gathered pairs L::WIDTH at a time, writes the hits to written and returns how many.
+    // Instantiated with Float8 in NarrowphaseAvx2.cpp, so it must not call any function that is
+    // not inlined or specific to L: the linker keeps one copy of a function compiled in both
+    // files, and the AVX2 one would crash on a CPU without it.
+    template<typename L, typename Kernel>
+    static size_t lanes(const Rows& f, const ColliderPair* pairs, size_t n, Contact* written) {
+        alignas(32) float nx[L::WIDTH], ny[L::WIDTH], depth[L::WIDTH];
+        size_t hitCount = 0;
+        for (size_t i = 0; i < n; i += L::WIDTH)
+        {
+            // the lanes past n compute garbage from whatever is left in the rows and are masked off
+            L normalX, normalY, penetration;
+            int hits = Simd::bits(Kernel::test(f, i, normalX, normalY, penetration));
+            if (n - i < size_t(L::WIDTH))
+                hits &= (1 << (n - i)) - 1;
+            if (!hits)
+                continue;
+            normalX.store(nx);
+            normalY.store(ny);
+            penetration.store(depth);
+            // every lane writes the next slot and only a hit keeps it: which lanes hit is close to
+            // random, and a branch per lane mispredicted more often than the write costs. The slot
+            // is never past pair i + lane, which prepare() made room for.
+            int laneCount = int(std::min(size_t(L::WIDTH), n - i));
+            for (int lane = 0; lane < laneCount; lane++)
+            {
+                Contact& contact = written[hitCount];
+                contact.a = pairs[i + lane].a;
+                contact.b = pairs[i + lane].b;
+                contact.normal.x = nx[lane];
+                contact.normal.y = ny[lane];
+                contact.depth = depth[lane];
+                hitCount += (hits >> lane) & 1;
+            }
+        }
+        return hitCount;
+    }
+
+    template<typename L, typename Kernel, typename Prefetch, typename Gather>
+    void run(const ColliderPair* pairs, size_t count, ContactBuffer& out, const Prefetch& prefetch, const Gather& gather) {
+        // far enough ahead to cover a miss to memory at one pair per few nanoseconds
+        const size_t PREFETCH_DISTANCE = 32;
+        for (size_t first = 0; first < count; first += BATCH)
+        {
+            size_t n = std::min(BATCH, count - first);
+            for (size_t i = 0; i < n; i++)
+            {
+                if (first + i + PREFETCH_DISTANCE < count)
+                    prefetch(pairs[first + i + PREFETCH_DISTANCE]);
+                gather(soa, i, pairs[first + i]);
+            }
+            Contact* written = out.prepare(n);
+            out.commit(test<L, Kernel>(soa, pairs + first, n, written));
+        }
+    }
+};
@@ -0,0 +1,507 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "Physics/AABB.hpp"
+#include "Physics/Shapes.hpp"
+#include "Physics/Manifold.hpp"
+#include "Physics/SpatialHash.hpp"
+#include "Core/JobSystem.hpp"
+#include "Core/Profiler.hpp"
+
+struct RigidBody {
+    glm::vec2 position = glm::vec2(0.0f);
+    glm::vec2 velocity = glm::vec2(0.0f);
+    float angle = 0.0f;
+    float angularVelocity = 0.0f;
+    glm::vec2 axis = glm::vec2(1.0f, 0.0f); // cos and sin of angle
+    glm::vec2 halfExtents = glm::vec2(0.5f);
+    float inverseMass = 0.0f; // 0 for static
+    float inverseInertia = 0.0f;
+    float friction = 0.5f;
+    float sleepTime = 0.0f; // how long it has been nearly still
+    bool awake = true;
+
+    // density 0 makes a static box
+    static RigidBody box(const glm::vec2& center, const glm::vec2& halfExtents, float density, float angle = 0.0f) {
+        RigidBody body;
+        body.position = center;
+        body.angle = angle;
+        body.axis = glm::vec2(std::cos(angle), std::sin(angle));
+        body.halfExtents = halfExtents;
+        if (density > 0.0f)
+        {
+            glm::vec2 size = halfExtents * 2.0f;
+            float mass = density * size.x * size.y;
+            body.inverseMass = 1.0f / mass;
+            body.inverseInertia = 12.0f / (mass * glm::dot(size, size));
+        }
+        return body;
+    }
+
+    bool isStatic() const {
+        return inverseMass == 0.0f;
+    }
+
+    OBB shape() const {
+        return { position, halfExtents, axis };
+    }
+};
+
+// Boxes with rotation, friction and gravity, solved with sequential impulses (Catto, "Iterative
+// Dynamics with Temporal Coherence"). Contact impulses are carried over from the last step by
+// feature, which is what lets a stack settle in a handful of iterations, and the two normal
+// impulses of a two point contact are solved together so even a perfectly aligned stack comes to rest.
+// Each step the bodies touching each other are grouped into islands; an island shares no dynamic
+// body with any other, so islands are solved on the JobSystem in parallel without locks. Static
+// bodies join no island and are only read. An island that has been still for TIME_TO_SLEEP goes to
+// sleep as a whole: its bodies are skipped until an awake body touches one of them, and contacts
+// between sleeping bodies are carried over instead of recomputed.
+// Results do not depend on the worker count: everything is ordered by body index or pair order.
+class RigidBodyWorld {
+public:
+    static constexpr int VELOCITY_ITERATIONS = 10;
+    static constexpr float BAUMGARTE = 0.2f;              // fraction of the penetration removed per step
+    static constexpr float ALLOWED_PENETRATION = 0.01f;   // slop that keeps resting contacts alive
+    static constexpr float TIME_TO_SLEEP = 0.5f;
+    static constexpr float LINEAR_SLEEP_TOLERANCE = 0.05f;
+    static constexpr float ANGULAR_SLEEP_TOLERANCE = 0.05f;
+
+    glm::vec2 gravity = glm::vec2(0.0f, -10.0f);
+
+private:
+    struct Island {
+        uint32_t firstBody, bodyCount;
+        uint32_t firstManifold, manifoldCount;
+        bool awake;
+    };
+
+    std::vector<RigidBody> bodies;
+    std::vector<AABB> bounds;
+    SpatialHash broadphase;
+    bool resizeCells = true; // bodies were added since the cell size was chosen
+    std::vector<Manifold> candidates; // one per broadphase pair, pointCount 0 when not touching
+    std::vector<Manifold> manifolds;
+    std::vector<Manifold> previous;   // last step's, looked up by key through previousTable
+    std::vector<uint32_t> previousTable;
+
+    std::vector<uint32_t> parent; // union-find over bodies
+    std::vector<uint32_t> islandOf;
+    std::vector<Island> islands;
+    std::vector<uint32_t> islandBodies;
+    std::vector<uint32_t> islandManifolds;
+    std::vector<uint32_t> awakeIslands;
+    size_t awakeBodies = 0;
+
+public:
+    uint32_t add(const RigidBody& body) {
+        bodies.push_back(body);
+        resizeCells = true;
+        return uint32_t(bodies.size() - 1);
+    }
+
+    const RigidBody& body(uint32_t id) const {
+        return bodies[id];
+    }
+
+    size_t size() const {
+        return bodies.size();
+    }
+
+    void wake(uint32_t id) {
+        if (!bodies[id].isStatic())
+        {
+            bodies[id].awake = true;
+            bodies[id].sleepTime = 0.0f;
+        }
+    }
+
+    // dynamic bodies simulated by the last step
+    size_t awakeCount() const {
+        return awakeBodies;
+    }
+
+    size_t islandCount() const {
+        return islands.size();
+    }
+
+    size_t manifoldCount() const {
+        return previous.size();
+    }
+
+    void step(float dt, JobSystem* jobs = nullptr) {
+        PROFILE_SCOPE("RigidBodyWorld step");
+        if (bodies.empty() || dt <= 0.0f)
+            return;
+        findContacts(jobs);
+        buildIslands();
+
+        {
+            PROFILE_SCOPE("Solve islands");
+            // the few big islands first would balance better, but pair order keeps the step
+            // independent of the worker count and islands are usually many and small
+            size_t grain = std::max<size_t>(1, awakeIslands.size() / (jobs ? size_t(jobs->workerCount()) * 8 : 1));
+            auto solveRange = [&](size_t first, size_t last) {
+                for (size_t i = first; i < last; i++)
+                    solveIsland(islands[awakeIslands[i]], dt);
+            };
+            if (jobs)
+                jobs->parallelFor(0, awakeIslands.size(), grain, solveRange);
+            else
+                solveRange(0, awakeIslands.size());
+        }
+
+        // the impulses this step ended with warm start the next one
+        std::swap(previous, manifolds);
+    }
+
+private:
+    void findContacts(JobSystem* jobs) {
+        PROFILE_SCOPE("Contacts");
+        bounds.resize(bodies.size());
+        for (size_t i = 0; i < bodies.size(); i++)
+            bounds[i] = bodies[i].shape().bounds();
+        if (resizeCells)
+        {
+            broadphase.setCellSize(SpatialHash::suggestCellSize(bounds.data(), bounds.size()));
+            resizeCells = false;
+        }
+        const std::vector<SpatialHash::Pair>& pairs = broadphase.build(bounds.data(), bounds.size(), jobs);
+
+        // open addressing from pair key to last step's manifold, index + 1 so 0 is empty
+        size_t tableSize = 16;
+        while (tableSize < previous.size() * 2)
+            tableSize *= 2;
+        previousTable.assign(tableSize, 0);
+        for (size_t i = 0; i < previous.size(); i++)
+        {
+            size_t slot = slotOf(previous[i].key(), tableSize);
+            while (previousTable[slot])
+                slot = (slot + 1) & (tableSize - 1);
+            previousTable[slot] = uint32_t(i + 1);
+        }
+
+        candidates.resize(pairs.size());
+        auto collideRange = [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++)
+            {
+                Manifold& manifold = candidates[i];
+                manifold.a = pairs[i].a;
+                manifold.b = pairs[i].b;
+                manifold.pointCount = 0;
+                const RigidBody& a = bodies[manifold.a];
+                const RigidBody& b = bodies[manifold.b];
+                bool activeA = !a.isStatic() && a.awake, activeB = !b.isStatic() && b.awake;
+                if (a.isStatic() && b.isStatic())
+                    continue;
+                const Manifold* old = find(manifold.key());
+                // nothing moved since the contact was made
+                if (!activeA && !activeB)
+                {
+                    if (old)
+                        manifold = *old;
+                    continue;
+                }
+                if (!BoxCollision::collide(a.shape(), b.shape(), manifold))
+                    continue;
+                manifold.friction = std::sqrt(a.friction * b.friction);
+                if (!old)
+                    continue;
+                for (int p = 0; p < manifold.pointCount; p++)
+                    for (int q = 0; q < old->pointCount; q++)
+                        if (manifold.points[p].feature == old->points[q].feature)
+                        {
+                            manifold.points[p].normalImpulse = old->points[q].normalImpulse;
+                            manifold.points[p].tangentImpulse = old->points[q].tangentImpulse;
+                            break;
+                        }
+            }
+        };
+        if (jobs)
+            jobs->parallelFor(0, candidates.size(), 1024, collideRange);
+        else
+            collideRange(0, candidates.size());
+
+        manifolds.clear();
+        for (const Manifold& manifold : candidates)
+            if (manifold.pointCount)
+                manifolds.push_back(manifold);
+    }
+
+    static size_t slotOf(uint64_t key, size_t tableSize) {
+        return size_t((key * 0x9E3779B97F4A7C15ull) >> 32) & (tableSize - 1);
+    }
+
+    const Manifold* find(uint64_t key) const {
+        size_t mask = previousTable.size() - 1;
+        for (size_t slot = slotOf(key, previousTable.size()); previousTable[slot]; slot = (slot + 1) & mask)
+            if (previous[previousTable[slot] - 1].key() == key)
+                return &previous[previousTable[slot] - 1];
+        return nullptr;
+    }
+
+    uint32_t root(uint32_t i) {
+        while (parent[i] != i)
+        {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+
+    // Islands are the connected components of dynamic bodies through contacts, numbered in order
+    // of their lowest body so the grouping is the same every run
+    void buildIslands() {
+        PROFILE_SCOPE("Islands");
+        size_t count = bodies.size();
+        parent.resize(count);
+        for (size_t i = 0; i < count; i++)
+            parent[i] = uint32_t(i);
+        for (const Manifold& manifold : manifolds)
+        {
+            if (bodies[manifold.a].isStatic() || bodies[manifold.b].isStatic())
+                continue;
+            uint32_t a = root(manifold.a), b = root(manifold.b);
+            if (a != b)
+                parent[std::max(a, b)] = std::min(a, b);
+        }
+
+        islands.clear();
+        islandOf.assign(count, UINT32_MAX);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (bodies[i].isStatic())
+                continue;
+            uint32_t r = root(uint32_t(i));
+            if (islandOf[r] == UINT32_MAX)
+            {
+                islandOf[r] = uint32_t(islands.size());
+                islands.push_back({ 0, 0, 0, 0, false });
+            }
+            islandOf[i] = islandOf[r];
+            Island& island = islands[islandOf[i]];
+            island.bodyCount++;
+            island.awake |= bodies[i].awake;
+        }
+        for (const Manifold& manifold : manifolds)
+            islands[islandOf[bodies[manifold.a].isStatic() ? manifold.b : manifold.a]].manifoldCount++;
+
+        // counting sort of bodies and manifolds by island
+        uint32_t bodyOffset = 0, manifoldOffset = 0;
+        for (Island& island : islands)
+        {
+            island.firstBody = bodyOffset;
+            island.firstManifold = manifoldOffset;
+            bodyOffset += island.bodyCount;
+            manifoldOffset += island.manifoldCount;
+            island.bodyCount = island.manifoldCount = 0;
+        }
+        islandBodies.resize(bodyOffset);
+        islandManifolds.resize(manifoldOffset);
+        for (size_t i = 0; i < count; i++)
+            if (!bodies[i].isStatic())
+            {
+                Island& island = islands[islandOf[i]];
+                islandBodies[island.firstBody + island.bodyCount++] = uint32_t(i);
+            }
+        for (size_t m = 0; m < manifolds.size(); m++)
+        {
+            const Manifold& manifold = manifolds[m];
+            Island& island = islands[islandOf[bodies[manifold.a].isStatic() ? manifold.b : manifold.a]];
+            islandManifolds[island.firstManifold + island.manifoldCount++] = uint32_t(m);
+        }
+
+        awakeIslands.clear();
+        awakeBodies = 0;
+        for (size_t i = 0; i < islands.size(); i++)
+            if (islands[i].awake)
+            {
+                awakeIslands.push_back(uint32_t(i));
+                awakeBodies += islands[i].bodyCount;
+            }
+    }
+
+    static glm::vec2 cross(float w, const glm::vec2& r) {
+        return glm::vec2(-w * r.y, w * r.x);
+    }
+
+    static float cross(const glm::vec2& a, const glm::vec2& b) {
+        return a.x * b.y - a.y * b.x;
+    }
+
+    // Touches only this island's bodies and manifolds; static bodies are read, never written
+    void solveIsland(const Island& island, float dt) {
+        const uint32_t* bodyIds = islandBodies.data() + island.firstBody;
+        const uint32_t* manifoldIds = islandManifolds.data() + island.firstManifold;
+
+        for (uint32_t i = 0; i < island.bodyCount; i++)
+        {
+            RigidBody& body = bodies[bodyIds[i]];
+            if (!body.awake)
+            {
+                body.awake = true;
+                body.sleepTime = 0.0f;
+            }
+            body.velocity += gravity * dt;
+        }
+
+        // precompute the effective masses and apply last step's impulses
+        float inverseDt = 1.0f / dt;
+        for (uint32_t m = 0; m < island.manifoldCount; m++)
+        {
+            Manifold& manifold = manifolds[manifoldIds[m]];
+            RigidBody& a = bodies[manifold.a];
+            RigidBody& b = bodies[manifold.b];
+            glm::vec2 normal = manifold.normal, tangent(normal.y, -normal.x);
+            for (int p = 0; p < manifold.pointCount; p++)
+            {
+                ManifoldPoint& point = manifold.points[p];
+                point.anchorA = point.position - a.position;
+                point.anchorB = point.position - b.position;
+                float rnA = cross(point.anchorA, normal), rnB = cross(point.anchorB, normal);
+                float rtA = cross(point.anchorA, tangent), rtB = cross(point.anchorB, tangent);
+                float inverseMass = a.inverseMass + b.inverseMass;
+                point.normalMass = 1.0f / (inverseMass + a.inverseInertia * rnA * rnA + b.inverseInertia * rnB * rnB);
+                point.tangentMass = 1.0f / (inverseMass + a.inverseInertia * rtA * rtA + b.inverseInertia * rtB * rtB);
+                point.bias = -BAUMGARTE * inverseDt * std::min(0.0f, point.separation + ALLOWED_PENETRATION);
+                applyImpulse(a, b, point, normal * point.normalImpulse + tangent * point.tangentImpulse);
+            }
+
+            // two points are solved together when the system is well conditioned (Box2D's limit)
+            manifold.blockSolve = false;
+            if (manifold.pointCount == 2)
+            {
+                const ManifoldPoint& point1 = manifold.points[0];
+                const ManifoldPoint& point2 = manifold.points[1];
+                float rn1A = cross(point1.anchorA, normal), rn1B = cross(point1.anchorB, normal);
+                float rn2A = cross(point2.anchorA, normal), rn2B = cross(point2.anchorB, normal);
+                float inverseMass = a.inverseMass + b.inverseMass;
+                float k11 = inverseMass + a.inverseInertia * rn1A * rn1A + b.inverseInertia * rn1B * rn1B;
+                float k22 = inverseMass + a.inverseInertia * rn2A * rn2A + b.inverseInertia * rn2B * rn2B;
+                float k12 = inverseMass + a.inverseInertia * rn1A * rn2A + b.inverseInertia * rn1B * rn2B;
+                if (k11 * k11 < 1000.0f * (k11 * k22 - k12 * k12))
+                {
+                    manifold.normalK = glm::mat2(k11, k12, k12, k22);
+                    manifold.normalKInverse = glm::inverse(manifold.normalK);
+                    manifold.blockSolve = true;
+                }
+            }
+        }
+
+        for (int iteration = 0; iteration < VELOCITY_ITERATIONS; iteration++)
+            for (uint32_t m = 0; m < island.manifoldCount; m++)
+            {
+                Manifold& manifold = manifolds[manifoldIds[m]];
+                RigidBody& a = bodies[manifold.a];
+                RigidBody& b = bodies[manifold.b];
+                glm::vec2 normal = manifold.normal, tangent(normal.y, -normal.x);
+                // friction first, inside the cone of the normal impulse the last iteration ended with,
+                // so non-penetration, which matters more, has the last word
+                for (int p = 0; p < manifold.pointCount; p++)
+                {
+                    ManifoldPoint& point = manifold.points[p];
+                    glm::vec2 relative = b.velocity + cross(b.angularVelocity, point.anchorB) - a.velocity - cross(a.angularVelocity, point.anchorA);
+                    float impulse = -point.tangentMass * glm::dot(relative, tangent);
+                    float limit = manifold.friction * point.normalImpulse;
+                    float total = std::clamp(point.tangentImpulse + impulse, -limit, limit);
+                    impulse = total - point.tangentImpulse;
+                    point.tangentImpulse = total;
+                    applyImpulse(a, b, point, tangent * impulse);
+                }
+
+                // non-penetration, accumulated impulse kept pushing
+                if (manifold.blockSolve)
+                {
+                    solveNormalPair(manifold, a, b);
+                    continue;
+                }
+                for (int p = 0; p < manifold.pointCount; p++)
+                {
+                    ManifoldPoint& point = manifold.points[p];
+                    glm::vec2 relative = b.velocity + cross(b.angularVelocity, point.anchorB) - a.velocity - cross(a.angularVelocity, point.anchorA);
+                    float impulse = point.normalMass * (point.bias - glm::dot(relative, normal));
+                    float total = std::max(point.normalImpulse + impulse, 0.0f);
+                    impulse = total - point.normalImpulse;
+                    point.normalImpulse = total;
+                    applyImpulse(a, b, point, normal * impulse);
+                }
+            }
+
+        // integrate, then sleep the island if every body in it has been still long enough
+        float leastSleep = TIME_TO_SLEEP;
+        for (uint32_t i = 0; i < island.bodyCount; i++)
+        {
+            RigidBody& body = bodies[bodyIds[i]];
+            body.position += body.velocity * dt;
+            body.angle += body.angularVelocity * dt;
+            body.axis = glm::vec2(std::cos(body.angle), std::sin(body.angle));
+            bool still = glm::dot(body.velocity, body.velocity) <= LINEAR_SLEEP_TOLERANCE * LINEAR_SLEEP_TOLERANCE &&
+                body.angularVelocity * body.angularVelocity <= ANGULAR_SLEEP_TOLERANCE * ANGULAR_SLEEP_TOLERANCE;
+            body.sleepTime = still ? body.sleepTime + dt : 0.0f;
+            leastSleep = std::min(leastSleep, body.sleepTime);
+        }
+        if (leastSleep >= TIME_TO_SLEEP)
+            for (uint32_t i = 0; i < island.bodyCount; i++)
+            {
+                RigidBody& body = bodies[bodyIds[i]];
+                body.awake = false;
+                body.velocity = glm::vec2(0.0f);
+                body.angularVelocity = 0.0f;
+            }
+    }
+
+    // Both normal impulses of a two point manifold at once (Box2D's block solver): one point solved
+    // after the other leaves a little spin behind every step, enough to keep a tall aligned stack
+    // swaying. Tries both points pushing, then either one alone, then neither, and keeps the first
+    // case whose impulses and resulting approach speeds are all non-negative.
+    void solveNormalPair(Manifold& manifold, RigidBody& a, RigidBody& b) {
+        ManifoldPoint& point1 = manifold.points[0];
+        ManifoldPoint& point2 = manifold.points[1];
+        const glm::vec2& normal = manifold.normal;
+        glm::vec2 relative1 = b.velocity + cross(b.angularVelocity, point1.anchorB) - a.velocity - cross(a.angularVelocity, point1.anchorA);
+        glm::vec2 relative2 = b.velocity + cross(b.angularVelocity, point2.anchorB) - a.velocity - cross(a.angularVelocity, point2.anchorA);
+        glm::vec2 accumulated(point1.normalImpulse, point2.normalImpulse);
+        // normal speeds the accumulated impulses would leave if they were taken back, less the bias
+        glm::vec2 rhs = glm::vec2(glm::dot(relative1, normal) - point1.bias, glm::dot(relative2, normal) - point2.bias) - manifold.normalK * accumulated;
+
+        glm::vec2 total = -(manifold.normalKInverse * rhs);
+        if (total.x < 0.0f || total.y < 0.0f)
+        {
+            total = glm::vec2(-point1.normalMass * rhs.x, 0.0f);
+            if (total.x < 0.0f || manifold.normalK[0][1] * total.x + rhs.y < 0.0f)
+            {
+                total = glm::vec2(0.0f, -point2.normalMass * rhs.y);
+                if (total.y < 0.0f || manifold.normalK[1][0] * total.y + rhs.x < 0.0f)
+                {
+                    total = glm::vec2(0.0f);
+                    // no case fits, which happens rarely and only for a step; keep the impulses
+                    if (rhs.x < 0.0f || rhs.y < 0.0f)
+                        return;
+                }
+            }
+        }
+        glm::vec2 impulse = total - accumulated;
+        applyImpulse(a, b, point1, normal * impulse.x);
+        applyImpulse(a, b, point2, normal * impulse.y);
+        point1.normalImpulse = total.x;
+        point2.normalImpulse = total.y;
+    }
+
+    static void applyImpulse(RigidBody& a, RigidBody& b, const ManifoldPoint& point, const glm::vec2& impulse) {
+        // a static body may be shared with islands on other threads
+        if (!a.isStatic())
+        {
+            a.velocity -= impulse * a.inverseMass;
+            a.angularVelocity -= a.inverseInertia * cross(point.anchorA, impulse);
+        }
+        if (!b.isStatic())
+        {
+            b.velocity += impulse * b.inverseMass;
+            b.angularVelocity += b.inverseInertia * cross(point.anchorB, impulse);
+        }
+    }
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstdint>
+
+#include "Physics/AABB.hpp"
+
+// Two colliders the broadphase found close enough to test, by index into the caller's arrays
+struct ColliderPair {
+    uint32_t a, b;
+};
+
+struct Circle {
+    glm::vec2 center = glm::vec2(0.0f);
+    float radius = 0.0f;
+
+    AABB bounds() const {
+        return AABB::fromCenter(center, glm::vec2(radius));
+    }
+};
+
+// Oriented box; axis is the unit local x axis, local y is axis rotated a quarter turn
+struct OBB {
+    glm::vec2 center = glm::vec2(0.0f);
+    glm::vec2 halfExtents = glm::vec2(0.0f);
+    glm::vec2 axis = glm::vec2(1.0f, 0.0f);
+
+    static OBB fromAngle(const glm::vec2& center, const glm::vec2& halfExtents, float radians) {
+        return { center, halfExtents, glm::vec2(std::cos(radians), std::sin(radians)) };
+    }
+
+    AABB bounds() const {
+        glm::vec2 extent = glm::abs(axis) * halfExtents.x + glm::abs(glm::vec2(-axis.y, axis.x)) * halfExtents.y;
+        return AABB::fromCenter(center, extent);
+    }
+};
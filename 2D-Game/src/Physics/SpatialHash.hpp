@@ -0,0 +1,407 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "Physics/AABB.hpp"
+#include "Physics/Shapes.hpp"
+#include "Physics/Sweep.hpp"
+#include "Core/JobSystem.hpp"
+#include "Core/Profiler.hpp"
+
+// Broadphase over a uniform grid, rebuilt from scratch every tick. Every (collider, cell) entry is
+// bucketed by its cell with a counting sort into one flat array, so there are no per-cell
+// containers and nothing to update incrementally. The bucket is the cell's row-major index when the
+// occupied cells are dense, and a hash of the cell when they are spread out.
+// A pair overlapping in several cells is only reported by the cell holding the min corner of the
+// overlap, which makes the output free of duplicates without a hash set.
+// With a JobSystem every pass runs in parallel, the counting sort included: the colliders are cut
+// into a few ranges that count their buckets into their own histogram row, a prefix sum over
+// (bucket, range) turns the rows into per-range cursors and each range then scatters on its own.
+// Entries land in the same order as a serial sort, so the pairs do not depend on the worker count.
+class SpatialHash {
+public:
+    using Pair = ColliderPair; // a < b
+
+private:
+    struct Entry {
+        AABB box;
+        uint32_t collider;
+        int32_t x, y;
+    };
+
+    // cells a collider covers, span = last - first
+    struct CellRange {
+        glm::ivec2 first, span;
+    };
+
+    // pairs of one bucket range: pairs[0, count) are found, the rest is room written ahead
+    struct PairBuffer {
+        std::vector<Pair> pairs;
+        size_t count = 0;
+    };
+
+    static constexpr size_t GRAIN = 2048;
+    static constexpr size_t MAX_SORT_RANGES = 8; // histogram rows, each as long as the bucket table
+
+    float cellSize = 1.0f;
+    float inverseCellSize = 1.0f;
+    uint32_t tableMask = 0;
+    glm::ivec2 gridOrigin = glm::ivec2(0), gridEnd = glm::ivec2(0); // occupied cells of the last build
+    uint32_t gridWidth = 0; // 0 when hashing
+
+    std::vector<CellRange> colliderCells;
+    std::vector<uint32_t> firstEntry;  // per collider, prefix sum of the cells it covers
+    std::vector<std::pair<glm::ivec2, glm::ivec2>> rangeBounds;
+    std::vector<uint32_t> entryBucket;   // collider order
+    std::vector<uint32_t> entryCollider; // collider order
+    std::vector<uint32_t> bucketStart; // counting sort offsets, tableSize + 1
+    std::vector<uint32_t> rangeCursor; // sort range major, one row of tableSize per range
+    std::vector<uint32_t> chunkStart;  // prefix of the bucket chunks of the parallel prefix sum
+    std::vector<Entry> sorted;
+    std::vector<PairBuffer> jobPairs;
+    std::vector<Pair> pairs;
+
+public:
+    SpatialHash(float cellSize = 1.0f) {
+        setCellSize(cellSize);
+    }
+
+    void setCellSize(float size) {
+        cellSize = std::max(size, 1e-4f);
+        inverseCellSize = 1.0f / cellSize;
+    }
+
+    float getCellSize() const {
+        return cellSize;
+    }
+
+    // Twice the typical collider keeps most colliders in one or two cells without making the
+    // buckets long; the mean of the larger extent is a good enough estimate of "typical".
+    static float suggestCellSize(const AABB* boxes, size_t count) {
+        if (count == 0)
+            return 1.0f;
+        double total = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            glm::vec2 size = boxes[i].size();
+            total += std::max(size.x, size.y);
+        }
+        return float(2.0 * total / double(count));
+    }
+
+    // Returns every pair of overlapping boxes. jobs splits the per-collider and per-bucket work.
+    const std::vector<Pair>& build(const AABB* boxes, size_t count, JobSystem* jobs = nullptr) {
+        PROFILE_SCOPE("Broadphase");
+        pairs.clear();
+        if (count == 0)
+            return pairs;
+
+        // cells covered per collider, then where each collider's entries start, and the bounds of
+        // the occupied cells per range
+        size_t ranges = (count + GRAIN - 1) / GRAIN;
+        colliderCells.resize(count);
+        firstEntry.resize(count + 1);
+        firstEntry[0] = 0;
+        rangeBounds.resize(ranges);
+        forRange(jobs, count, GRAIN, [&](size_t first, size_t last) {
+            glm::ivec2 lo = cell(boxes[first].min), hi = cell(boxes[first].max);
+            for (size_t i = first; i < last; i++)
+            {
+                glm::ivec2 boxLo = cell(boxes[i].min), boxHi = cell(boxes[i].max);
+                colliderCells[i] = { boxLo, boxHi - boxLo };
+                firstEntry[i + 1] = uint32_t((boxHi.x - boxLo.x + 1) * (boxHi.y - boxLo.y + 1));
+                lo = glm::min(lo, boxLo);
+                hi = glm::max(hi, boxHi);
+            }
+            rangeBounds[first / GRAIN] = { lo, hi };
+        });
+        for (size_t i = 0; i < count; i++)
+            firstEntry[i + 1] += firstEntry[i];
+        size_t entryCount = firstEntry[count];
+        glm::ivec2 lo = rangeBounds[0].first, hi = rangeBounds[0].second;
+        for (size_t r = 1; r < ranges; r++)
+        {
+            lo = glm::min(lo, rangeBounds[r].first);
+            hi = glm::max(hi, rangeBounds[r].second);
+        }
+
+        // when the occupied cells are dense enough the row-major cell index is the bucket, which
+        // cannot collide and keeps neighbouring cells next to each other; otherwise hash
+        int64_t gridCells = int64_t(hi.x - lo.x + 1) * int64_t(hi.y - lo.y + 1);
+        size_t tableSize;
+        gridOrigin = lo;
+        gridEnd = hi;
+        if (gridCells <= int64_t(entryCount) * 2)
+        {
+            gridWidth = uint32_t(hi.x - lo.x + 1);
+            tableSize = size_t(gridCells);
+        }
+        else
+        {
+            gridWidth = 0;
+            tableSize = 16;
+            while (tableSize < entryCount)
+                tableSize *= 2;
+            tableMask = uint32_t(tableSize - 1);
+        }
+
+        // the bucket and collider of every entry, so the sort passes below walk the entries in a flat
+        // loop instead of looping over each collider's cells again
+        entryBucket.resize(entryCount);
+        entryCollider.resize(entryCount);
+        forRange(jobs, count, GRAIN, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++)
+            {
+                const CellRange& cells = colliderCells[i];
+                uint32_t* bucket = entryBucket.data() + firstEntry[i];
+                uint32_t* collider = entryCollider.data() + firstEntry[i];
+                if (cells.span.x <= 1 && cells.span.y <= 1)
+                {
+                    // at most 2x2 cells, the common case at the suggested cell size: the four
+                    // corners land on their slots, or on the same slot when a span is 0, which
+                    // saves the loops' mispredicted exits
+                    int x = cells.first.x, y = cells.first.y, spanX = cells.span.x, spanY = cells.span.y;
+                    int row = spanY * (spanX + 1);
+                    bucket[0] = hash(x, y);
+                    bucket[spanX] = hash(x + spanX, y);
+                    bucket[row] = hash(x, y + spanY);
+                    bucket[row + spanX] = hash(x + spanX, y + spanY);
+                    collider[0] = collider[spanX] = collider[row] = collider[row + spanX] = uint32_t(i);
+                    continue;
+                }
+                for (int y = 0; y <= cells.span.y; y++)
+                    for (int x = 0; x <= cells.span.x; x++)
+                    {
+                        *bucket++ = hash(cells.first.x + x, cells.first.y + y);
+                        *collider++ = uint32_t(i);
+                    }
+            }
+        });
+
+        // counting sort by bucket. The box is copied into the entry so the pair loop reads the
+        // buckets front to back instead of chasing collider indices.
+        size_t sortRanges = jobs ? std::min({ size_t(jobs->workerCount()), MAX_SORT_RANGES, (count + GRAIN - 1) / GRAIN }) : 1;
+        size_t sortGrain = (count + sortRanges - 1) / sortRanges;
+        rangeCursor.resize(sortRanges * tableSize);
+        forRange(jobs, sortRanges, 1, [&](size_t first, size_t last) {
+            for (size_t r = first; r < last; r++)
+            {
+                uint32_t* histogram = rangeCursor.data() + r * tableSize;
+                std::fill(histogram, histogram + tableSize, 0u);
+                size_t begin = firstEntry[std::min(r * sortGrain, count)], end = firstEntry[std::min((r + 1) * sortGrain, count)];
+                for (size_t e = begin; e < end; e++)
+                    histogram[entryBucket[e]]++;
+            }
+        });
+        // entries of a bucket go range by range: first each bucket's total and its ranges' offsets
+        // inside it, per chunk of buckets, then the chunks' starts, then the absolute cursors
+        bucketStart.resize(tableSize + 1);
+        size_t chunks = (tableSize + GRAIN - 1) / GRAIN;
+        chunkStart.resize(chunks + 1);
+        forRange(jobs, tableSize, GRAIN, [&](size_t first, size_t last) {
+            uint32_t chunkTotal = 0;
+            for (size_t b = first; b < last; b++)
+            {
+                uint32_t total = 0;
+                for (size_t r = 0; r < sortRanges; r++)
+                {
+                    uint32_t& slot = rangeCursor[r * tableSize + b];
+                    uint32_t entries = slot;
+                    slot = total;
+                    total += entries;
+                }
+                bucketStart[b] = total;
+                chunkTotal += total;
+            }
+            chunkStart[first / GRAIN + 1] = chunkTotal;
+        });
+        chunkStart[0] = 0;
+        for (size_t c = 0; c < chunks; c++)
+            chunkStart[c + 1] += chunkStart[c];
+        forRange(jobs, tableSize, GRAIN, [&](size_t first, size_t last) {
+            uint32_t start = chunkStart[first / GRAIN];
+            for (size_t b = first; b < last; b++)
+            {
+                uint32_t total = bucketStart[b];
+                bucketStart[b] = start;
+                for (size_t r = 0; r < sortRanges; r++)
+                    rangeCursor[r * tableSize + b] += start;
+                start += total;
+            }
+        });
+        bucketStart[tableSize] = uint32_t(entryCount);
+
+        sorted.resize(entryCount);
+        forRange(jobs, sortRanges, 1, [&](size_t first, size_t last) {
+            for (size_t r = first; r < last; r++)
+            {
+                uint32_t* cursor = rangeCursor.data() + r * tableSize;
+                size_t begin = firstEntry[std::min(r * sortGrain, count)], end = firstEntry[std::min((r + 1) * sortGrain, count)];
+                for (size_t e = begin; e < end; e++)
+                {
+                    uint32_t i = entryCollider[e];
+                    const CellRange& cells = colliderCells[i];
+                    // the entry's cell from its index among the collider's, row-major
+                    uint32_t n = uint32_t(e - firstEntry[i]), x, y;
+                    if (cells.span.x <= 1)
+                    {
+                        x = n & uint32_t(cells.span.x);
+                        y = n >> cells.span.x;
+                    }
+                    else
+                    {
+                        x = n % uint32_t(cells.span.x + 1);
+                        y = n / uint32_t(cells.span.x + 1);
+                    }
+                    sorted[cursor[entryBucket[e]]++] = { boxes[i], i, cells.first.x + int32_t(x), cells.first.y + int32_t(y) };
+                }
+            }
+        });
+
+        // pairs per bucket range, each range into its own list so the output order is deterministic
+        ranges = (tableSize + GRAIN - 1) / GRAIN;
+        if (jobPairs.size() < ranges)
+            jobPairs.resize(ranges);
+        forRange(jobs, tableSize, GRAIN, [&](size_t first, size_t last) {
+            PairBuffer& out = jobPairs[first / GRAIN];
+            out.count = 0;
+            for (size_t b = first; b < last; b++)
+                findPairs(bucketStart[b], bucketStart[b + 1], out);
+        });
+        for (size_t r = 0; r < ranges; r++)
+            pairs.insert(pairs.end(), jobPairs[r].pairs.begin(), jobPairs[r].pairs.begin() + jobPairs[r].count);
+        return pairs;
+    }
+
+    const std::vector<Pair>& candidatePairs() const {
+        return pairs;
+    }
+
+    // Earliest hit of box moving by delta against the boxes of the last build, skipping the
+    // collider ignore (usually the mover itself). Only the cells under the swept box are visited.
+    SweepHit sweep(const AABB& box, const glm::vec2& delta, uint32_t ignore = SweepHit::NONE) const {
+        SweepHit best;
+        if (sorted.empty())
+            return best;
+        AABB swept = AABB::merge(box, { box.min + delta, box.max + delta });
+        glm::ivec2 lo = cell(swept.min), hi = cell(swept.max);
+        if (gridWidth)
+        {
+            // no entries outside the occupied cells, and the row-major index is only valid inside
+            lo = glm::max(lo, gridOrigin);
+            hi = glm::min(hi, gridEnd);
+            if (lo.x > hi.x || lo.y > hi.y)
+                return best;
+        }
+        auto test = [&](const Entry& entry) {
+            float time;
+            glm::vec2 normal;
+            if (entry.collider != ignore && sweepAABB(box, delta, entry.box, time, normal) && (time < best.time || !best.hit()))
+            {
+                best.time = time;
+                best.normal = normal;
+                best.collider = entry.collider;
+            }
+        };
+        // a sweep across more cells than there are entries is cheaper as a scan of every entry
+        if (int64_t(hi.x - lo.x + 1) * int64_t(hi.y - lo.y + 1) > int64_t(sorted.size()))
+        {
+            for (const Entry& entry : sorted)
+                test(entry);
+            return best;
+        }
+        for (int y = lo.y; y <= hi.y; y++)
+        {
+            // only the part of the row the box passes through, so a long diagonal sweep visits a
+            // band of cells rather than its whole bounding rectangle
+            float rowMin = float(y) * cellSize, rowMax = rowMin + cellSize;
+            float first = 0.0f, last = 1.0f;
+            if (delta.y != 0.0f)
+            {
+                float t1 = (rowMin - box.max.y) / delta.y, t2 = (rowMax - box.min.y) / delta.y;
+                first = std::max(std::min(t1, t2), 0.0f);
+                last = std::min(std::max(t1, t2), 1.0f);
+            }
+            float minX = box.min.x + delta.x * (delta.x < 0.0f ? last : first);
+            float maxX = box.max.x + delta.x * (delta.x < 0.0f ? first : last);
+            int rowLo = std::max(floorToInt(minX * inverseCellSize), lo.x);
+            int rowHi = std::min(floorToInt(maxX * inverseCellSize), hi.x);
+            for (int x = rowLo; x <= rowHi; x++)
+            {
+                uint32_t bucket = hash(x, y);
+                for (uint32_t e = bucketStart[bucket]; e < bucketStart[bucket + 1]; e++)
+                    if (sorted[e].x == x && sorted[e].y == y)
+                        test(sorted[e]);
+            }
+        }
+        return best;
+    }
+
+    // (collider, cell) entries of the last build, the average bucket load is this / colliders
+    size_t entryCount() const {
+        return sorted.size();
+    }
+
+private:
+    glm::ivec2 cell(const glm::vec2& point) const {
+        return glm::ivec2(floorToInt(point.x * inverseCellSize), floorToInt(point.y * inverseCellSize));
+    }
+
+    // std::floor is a libm call unless the target has SSE4.1, and it runs several times per collider
+    static int floorToInt(float value) {
+        int truncated = int(value);
+        return truncated - (value < float(truncated));
+    }
+
+    uint32_t hash(int32_t x, int32_t y) const {
+        if (gridWidth)
+            return uint32_t(y - gridOrigin.y) * gridWidth + uint32_t(x - gridOrigin.x);
+        return ((uint32_t(x) * 73856093u) ^ (uint32_t(y) * 19349663u)) & tableMask;
+    }
+
+    // Every pair is written to the next slot and only counted when it holds, with no branch on the
+    // tests: whether two boxes in a bucket overlap is a coin toss, and mispredicting it cost more
+    // than the tests themselves.
+    void findPairs(uint32_t first, uint32_t last, PairBuffer& out) const {
+        size_t entries = last - first, tests = entries * (entries - 1) / 2;
+        if (out.count + tests > out.pairs.size())
+            out.pairs.resize(std::max(out.pairs.size() * 2, out.count + tests));
+        Pair* slot = out.pairs.data();
+        size_t count = out.count;
+        for (uint32_t i = first; i < last; i++)
+        {
+            const Entry& a = sorted[i];
+            for (uint32_t j = i + 1; j < last; j++)
+            {
+                const Entry& b = sorted[j];
+                // same cell, not just another one hashed into the bucket, overlapping, and the
+                // cell holds the min corner of the overlap
+                glm::ivec2 owner = cell(glm::max(a.box.min, b.box.min));
+                bool found = (a.x == b.x) & (a.y == b.y) &
+                    (a.box.min.x <= b.box.max.x) & (b.box.min.x <= a.box.max.x) & (a.box.min.y <= b.box.max.y) & (b.box.min.y <= a.box.max.y) &
+                    (owner.x == a.x) & (owner.y == a.y);
+                slot[count] = { std::min(a.collider, b.collider), std::max(a.collider, b.collider) };
+                count += found;
+            }
+        }
+        out.count = count;
+    }
+
+    // body(first, last) once per grain sized chunk, first a multiple of grain: the bodies index
+    // their per-chunk outputs with first / grain, so chunks are never merged even on one worker
+    template<typename Body>
+    void forRange(JobSystem* jobs, size_t count, size_t grain, const Body& body) {
+        auto chunks = [&](size_t firstChunk, size_t lastChunk) {
+            for (size_t c = firstChunk; c < lastChunk; c++)
+                body(c * grain, std::min((c + 1) * grain, count));
+        };
+        size_t chunkCount = (count + grain - 1) / grain;
+        if (jobs)
+            jobs->parallelFor(0, chunkCount, 1, chunks);
+        else
+            chunks(0, chunkCount);
+    }
+};
@@ -0,0 +1,83 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include "Physics/AABB.hpp"
+#include "Physics/DynamicTree.hpp"
+#include "Physics/Sweep.hpp"
+
+// Level collision that never moves: walls, floors, props. Kept in a DynamicTree with no margin,
+// since nothing is ever reinserted, so a sweep only tests the boxes near its path however long
+// and thin they are.
+class StaticGeometry {
+private:
+    DynamicTree tree{ 0.0f };
+    std::vector<AABB> boxes;      // by id
+    std::vector<uint32_t> proxies; // by id, DynamicTree::NONE once removed
+    std::vector<uint32_t> freeIds;
+
+public:
+    uint32_t add(const AABB& box) {
+        uint32_t id;
+        if (!freeIds.empty())
+        {
+            id = freeIds.back();
+            freeIds.pop_back();
+        }
+        else
+        {
+            id = uint32_t(boxes.size());
+            boxes.push_back(AABB());
+            proxies.push_back(DynamicTree::NONE);
+        }
+        boxes[id] = box;
+        proxies[id] = tree.create(box, id);
+        return id;
+    }
+
+    void remove(uint32_t id) {
+        if (id >= proxies.size() || proxies[id] == DynamicTree::NONE)
+            return;
+        tree.destroy(proxies[id]);
+        proxies[id] = DynamicTree::NONE;
+        freeIds.push_back(id);
+    }
+
+    const AABB& box(uint32_t id) const {
+        return boxes[id];
+    }
+
+    size_t size() const {
+        return boxes.size() - freeIds.size();
+    }
+
+    // Earliest hit of box moving by delta, collider is the geometry id
+    SweepHit sweep(const AABB& box, const glm::vec2& delta) const {
+        SweepHit best;
+        AABB swept = AABB::merge(box, { box.min + delta, box.max + delta });
+        tree.query(swept, [&](uint32_t proxy) {
+            uint32_t id = tree.userData(proxy);
+            float time;
+            glm::vec2 normal;
+            if (sweepAABB(box, delta, boxes[id], time, normal) && (time < best.time || !best.hit()))
+            {
+                best.time = time;
+                best.normal = normal;
+                best.collider = id;
+            }
+            return true;
+        });
+        return best;
+    }
+
+    // Calls f(id) for every box overlapping region; f returns false to stop
+    template<typename F>
+    void query(const AABB& region, F&& f) const {
+        tree.query(region, [&](uint32_t proxy) {
+            uint32_t id = tree.userData(proxy);
+            return boxes[id].overlaps(region) ? bool(f(id)) : true;
+        });
+    }
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <algorithm>
+
+#include "Physics/AABB.hpp"
+
+// First contact along a displacement
+struct SweepHit {
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    float time = 1.0f;                   // fraction of the displacement travelled before contact
+    glm::vec2 normal = glm::vec2(0.0f); // of the surface that was hit, facing the mover
+    uint32_t collider = NONE;
+
+    bool hit() const {
+        return collider != NONE;
+    }
+};
+
+// Time of impact of box moving by delta against a static target: the target grown by the box's
+// half size, hit by a ray from the box's center. A box that already overlaps the target reports
+// time 0 with the normal of least penetration, but only while moving further in, so a mover
+// that starts stuck can still leave. Touching without overlap is not a hit.
+inline bool sweepAABB(const AABB& box, const glm::vec2& delta, const AABB& target, float& time, glm::vec2& normal) {
+    glm::vec2 half = box.size() * 0.5f;
+    glm::vec2 origin = box.center();
+    AABB grown = { target.min - half, target.max + half };
+
+    float enter = -1e30f, leave = 1e30f;
+    glm::vec2 enterNormal(0.0f);
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (delta[axis] == 0.0f)
+        {
+            if (origin[axis] <= grown.min[axis] || origin[axis] >= grown.max[axis])
+                return false;
+            continue;
+        }
+        float inverse = 1.0f / delta[axis];
+        float t1 = (grown.min[axis] - origin[axis]) * inverse;
+        float t2 = (grown.max[axis] - origin[axis]) * inverse;
+        if (t1 > t2)
+            std::swap(t1, t2);
+        if (t1 > enter)
+        {
+            enter = t1;
+            enterNormal = glm::vec2(0.0f);
+            enterNormal[axis] = delta[axis] > 0.0f ? -1.0f : 1.0f;
+        }
+        leave = std::min(leave, t2);
+    }
+    if (enter >= leave || leave <= 0.0f || enter > 1.0f)
+        return false;
+    if (enter >= 0.0f)
+    {
+        time = enter;
+        normal = enterNormal;
+        return true;
+    }
+
+    // started inside: push out along the shallowest axis
+    glm::vec2 toMin = origin - grown.min, toMax = grown.max - origin;
+    glm::vec2 depth = glm::min(toMin, toMax);
+    glm::vec2 out = depth.x < depth.y ? glm::vec2(toMin.x < toMax.x ? -1.0f : 1.0f, 0.0f) : glm::vec2(0.0f, toMin.y < toMax.y ? -1.0f : 1.0f);
+    if (glm::dot(delta, out) >= 0.0f)
+        return false;
+    time = 0.0f;
+    normal = out;
+    return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+#include "Core/MappedFile.hpp"
+
+// S3TC is an extension, so the glad loader we ship has no enums for it
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// .ctex container, a stripped down KTX2: header, one entry per mip level, then the
+// block data of every level. Offsets are from the start of the file and 16 byte aligned.
+enum class BlockFormat : uint32_t {
+    BC1 = 1, // RGB + 1 bit alpha, 8 bytes per 4x4 block
+    BC3 = 3, // RGBA, 16 bytes per 4x4 block
+    BC7 = 7, // RGBA, 16 bytes per 4x4 block
+};
+
+struct CompressedTextureHeader {
+    char magic[4];
+    uint32_t version;
+    BlockFormat format;
+    uint32_t width, height;
+    uint32_t mipCount;
+};
+
+struct CompressedMipLevel {
+    uint64_t offset;
+    uint64_t size;
+    uint32_t width, height;
+};
+
+inline constexpr char COMPRESSED_TEXTURE_MAGIC[4] = { 'C', 'T', 'E', 'X' };
+inline constexpr uint32_t COMPRESSED_TEXTURE_VERSION = 1;
+inline constexpr uint32_t MAX_COMPRESSED_TEXTURE_SIZE = 16384;
+
+inline uint32_t blockBytes(BlockFormat format) {
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+inline GLenum blockGLFormat(BlockFormat format) {
+    switch (format)
+    {
+    case BlockFormat::BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    case BlockFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BlockFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+    return 0;
+}
+
+// Validates a mapped .ctex file and returns its header and level table, or nullptr if it is malformed.
+// Everything glTextureStorage2D and the uploads will be told is checked: the chain is no longer than
+// the full one, every level has the size the chain implies and exactly its blocks' bytes, and no
+// level reaches past the end of the file.
+inline const CompressedTextureHeader* readCompressedTexture(const MappedFile& file, const CompressedMipLevel*& levels) {
+    if (file.size() < sizeof(CompressedTextureHeader))
+        return nullptr;
+    auto header = reinterpret_cast<const CompressedTextureHeader*>(file.data());
+    if (std::memcmp(header->magic, COMPRESSED_TEXTURE_MAGIC, 4) != 0 || header->version != COMPRESSED_TEXTURE_VERSION ||
+        blockGLFormat(header->format) == 0 || header->width == 0 || header->height == 0 ||
+        header->width > MAX_COMPRESSED_TEXTURE_SIZE || header->height > MAX_COMPRESSED_TEXTURE_SIZE)
+        return nullptr;
+    uint32_t fullChain = 1;
+    while ((header->width | header->height) >> fullChain)
+        fullChain++;
+    if (header->mipCount == 0 || header->mipCount > fullChain ||
+        file.size() < sizeof(CompressedTextureHeader) + header->mipCount * sizeof(CompressedMipLevel))
+        return nullptr;
+    levels = reinterpret_cast<const CompressedMipLevel*>(file.data() + sizeof(CompressedTextureHeader));
+    for (uint32_t i = 0; i < header->mipCount; i++)
+    {
+        const CompressedMipLevel& level = levels[i];
+        uint32_t width = std::max(1u, header->width >> i), height = std::max(1u, header->height >> i);
+        uint64_t blocks = uint64_t((width + 3) / 4) * ((height + 3) / 4);
+        if (level.width != width || level.height != height || level.size != blocks * blockBytes(header->format) ||
+            level.offset > file.size() || level.size > file.size() - level.offset)
+            return nullptr;
+    }
+    return header;
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+#include "Core/Clock.hpp"
+
+// Paces the render thread: caps how many frames the driver may queue (one fence per presented
+// frame), optionally limits the frame rate, and measures input-to-present latency.
+// Call waitForFrame() before taking the newest FramePacket and framePresented() after the swap.
+// Latency ends when the GPU gets past the swap, read from a GL_TIMESTAMP query issued right after
+// it and shifted onto the CPU clock, so it does not depend on when the fence is next polled.
+class FramePacer {
+private:
+    struct InFlight {
+        GLsync fence;
+        GLuint query;       // GL_TIMESTAMP right after the swap
+        double inputTime;   // < 0 when the frame showed no new input
+        double cpuTime;     // clock.seconds() and GL_TIMESTAMP sampled together at the swap
+        int64_t gpuTime;
+    };
+
+    const Clock& clock;
+    std::deque<InFlight> inFlight;
+    std::vector<GLuint> freeQueries;
+    int maxFramesInFlight;
+    double frameSeconds;
+    double nextDeadline = 0.0;
+
+    // running estimate of how long sleep_for(1ms) really takes (Welford), so sleeping stops
+    // early enough on coarse OS timers and the rest of the wait is a short spin
+    double sleepMean = 0.005, sleepM2 = 0.0;
+    int64_t sleepSamples = 1;
+
+    double lastLatency = 0.0, averageLatency = 0.0, worstLatency = 0.0;
+    uint64_t latencySamples = 0;
+    double waitedSeconds = 0.0;
+
+public:
+    // targetFrameRate 0 leaves the rate to the swap interval
+    FramePacer(const Clock& clock, int maxFramesInFlight = 2, double targetFrameRate = 0.0)
+        : clock(clock), maxFramesInFlight(std::max(1, maxFramesInFlight)) {
+        setTargetFrameRate(targetFrameRate);
+    }
+
+    ~FramePacer() {
+        for (const InFlight& frame : inFlight)
+        {
+            glDeleteSync(frame.fence);
+            glDeleteQueries(1, &frame.query);
+        }
+        if (!freeQueries.empty())
+            glDeleteQueries(GLsizei(freeQueries.size()), freeQueries.data());
+    }
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    void setTargetFrameRate(double targetFrameRate) {
+        frameSeconds = targetFrameRate > 0.0 ? 1.0 / targetFrameRate : 0.0;
+    }
+
+    void setMaxFramesInFlight(int frames) {
+        maxFramesInFlight = std::max(1, frames);
+    }
+
+    // Blocks until the GPU has room for another frame and the frame limiter allows it to start
+    void waitForFrame() {
+        double start = clock.seconds();
+        retireFences(false);
+        while (int(inFlight.size()) >= maxFramesInFlight)
+            retireFences(true);
+
+        if (frameSeconds > 0.0)
+        {
+            double now = clock.seconds();
+            if (nextDeadline > now)
+                sleepUntil(nextDeadline);
+            // resync after a long frame instead of rushing to catch up
+            nextDeadline = std::max(nextDeadline + frameSeconds, clock.seconds());
+        }
+        waitedSeconds = clock.seconds() - start;
+    }
+
+    // inputTime is when the input shown by this frame was sampled, pass < 0 for repeated frames
+    void framePresented(double inputTime) {
+        GLuint query = 0;
+        if (freeQueries.empty())
+            glGenQueries(1, &query);
+        else
+        {
+            query = freeQueries.back();
+            freeQueries.pop_back();
+        }
+        glQueryCounter(query, GL_TIMESTAMP);
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        inFlight.push_back({ fence, query, inputTime, clock.seconds(), int64_t(gpuNow) });
+    }
+
+    double latency() const {
+        return lastLatency;
+    }
+
+    double averageLatencySeconds() const {
+        return averageLatency;
+    }
+
+    double worstLatencySeconds() const {
+        return worstLatency;
+    }
+
+    // time the last waitForFrame spent blocked, GPU-bound frames show up here
+    double lastWaitSeconds() const {
+        return waitedSeconds;
+    }
+
+private:
+    // retires finished frames; with block it waits for the oldest one in 1ms slices
+    void retireFences(bool block) {
+        while (!inFlight.empty())
+        {
+            GLenum status = glClientWaitSync(inFlight.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, block ? 1000000 : 0);
+            if (status == GL_TIMEOUT_EXPIRED)
+            {
+                if (!block)
+                    return;
+                continue;
+            }
+            // the query was issued before the fence, so its result is in without waiting
+            const InFlight& frame = inFlight.front();
+            GLuint64 gpuDone = 0;
+            glGetQueryObjectui64v(frame.query, GL_QUERY_RESULT, &gpuDone);
+            recordLatency(frame.inputTime, frame.cpuTime + double(int64_t(gpuDone) - frame.gpuTime) * 1e-9);
+            glDeleteSync(frame.fence);
+            freeQueries.push_back(frame.query);
+            inFlight.pop_front();
+            if (block)
+                return;
+        }
+    }
+
+    void recordLatency(double inputTime, double presentTime) {
+        if (inputTime < 0.0)
+            return;
+        lastLatency = presentTime - inputTime;
+        latencySamples++;
+        averageLatency += (lastLatency - averageLatency) / double(std::min<uint64_t>(latencySamples, 120));
+        worstLatency = std::max(worstLatency * 0.999, lastLatency);
+    }
+
+    void sleepUntil(double deadline) {
+        while (true)
+        {
+            double remaining = deadline - clock.seconds();
+            double estimate = sleepMean + std::sqrt(sleepM2 / double(sleepSamples));
+            if (remaining <= estimate)
+                break;
+            double before = clock.seconds();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            double observed = clock.seconds() - before;
+
+            sleepSamples++;
+            double delta = observed - sleepMean;
+            sleepMean += delta / double(sleepSamples);
+            sleepM2 += delta * (observed - sleepMean);
+        }
+        while (clock.seconds() < deadline)
+            std::this_thread::yield();
+    }
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Core/Transform.hpp"
+
+struct TextRun {
+    std::string text;
+    glm::vec2 position;
+    float scale;
+    glm::vec3 color;
+};
+
+// Everything the render thread needs for one simulation tick. The game thread fills one,
+// publishes it through a TripleBuffer and never touches it again until it is handed back.
+struct FramePacket {
+    // sprite i is drawn blended from previous[i] to current[i] by the time since tickTime
+    std::vector<Transform> previous;
+    std::vector<Transform> current;
+    std::vector<uint16_t> frames;
+    std::vector<TextRun> texts;
+
+    float zoom = 1.0f;
+    int viewportWidth = 0, viewportHeight = 0;
+    double tickTime = 0.0;    // clock seconds when the current state was simulated
+    double tickSeconds = 0.0;
+    double inputTime = 0.0;   // clock seconds when the input behind this state was sampled
+
+    // keeps capacity, the packets are recycled every tick
+    void reset() {
+        previous.clear();
+        current.clear();
+        frames.clear();
+        texts.clear();
+    }
+
+    // interpolation factor for a frame presented at `now`
+    float alpha(double now) const {
+        if (tickSeconds <= 0.0)
+            return 1.0f;
+        double t = (now - tickTime) / tickSeconds;
+        return float(t < 0.0 ? 0.0 : t > 1.0 ? 1.0 : t);
+    }
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <glad/glad.h>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "Core/Profiler.hpp"
+
+// GPU side of the profiler. Each section is a pair of GL_TIMESTAMP queries wrapped in a debug group,
+// so the same labels show up in RenderDoc/Nsight. Results are read back FRAMES_BEHIND frames later
+// without stalling and land on a "GPU" track of the CPU profiler, shifted onto the CPU clock.
+// Render thread only.
+class GpuProfiler {
+private:
+    static constexpr int FRAMES_BEHIND = 4;
+    static constexpr int SECTIONS_PER_FRAME = 32;
+
+    struct Section {
+        const char* name;
+    };
+
+    struct Frame {
+        GLuint queries[SECTIONS_PER_FRAME * 2];
+        Section sections[SECTIONS_PER_FRAME];
+        int used = 0;
+        int64_t cpuMinusGpu = 0; // Profiler::now() - GL_TIMESTAMP, sampled when the frame began
+    };
+
+    Frame frames[FRAMES_BEHIND];
+    int current = 0;
+    Profiler::Track* track = nullptr;
+    uint64_t dropped = 0;
+    double frameSeconds = 0.0;
+
+public:
+    GpuProfiler() {
+#if PROFILING
+        for (Frame& frame : frames)
+            glGenQueries(SECTIONS_PER_FRAME * 2, frame.queries);
+        track = Profiler::createTrack("GPU");
+#endif
+    }
+
+    ~GpuProfiler() {
+#if PROFILING
+        for (Frame& frame : frames)
+            glDeleteQueries(SECTIONS_PER_FRAME * 2, frame.queries);
+#endif
+    }
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // Collects the oldest frame's results and starts recording a new one
+    void beginFrame() {
+#if PROFILING
+        current = (current + 1) % FRAMES_BEHIND;
+        Frame& frame = frames[current];
+        collect(frame);
+        frame.used = 0;
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        frame.cpuMinusGpu = Profiler::now() - int64_t(gpuNow);
+#endif
+    }
+
+    // returns the section index to hand to end(), -1 when the frame ran out of queries
+    int begin(const char* name) {
+        glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+        Frame& frame = frames[current];
+        if (frame.used == SECTIONS_PER_FRAME)
+            return -1;
+        int index = frame.used++;
+        frame.sections[index].name = name;
+        glQueryCounter(frame.queries[index * 2], GL_TIMESTAMP);
+        return index;
+    }
+
+    void end(int index) {
+        if (index >= 0)
+            glQueryCounter(frames[current].queries[index * 2 + 1], GL_TIMESTAMP);
+        glPopDebugGroup();
+    }
+
+    // first section start to last section end of the newest collected frame
+    double lastFrameSeconds() const {
+        return frameSeconds;
+    }
+
+    // sections whose results were not ready in time
+    uint64_t droppedSections() const {
+        return dropped;
+    }
+
+    class Scope {
+    private:
+        GpuProfiler& profiler;
+        int index;
+
+    public:
+        Scope(GpuProfiler& profiler, const char* name) : profiler(profiler), index(profiler.begin(name)) {}
+        ~Scope() {
+            profiler.end(index);
+        }
+    };
+
+private:
+    void collect(Frame& frame) {
+        GLuint64 first = ~GLuint64(0), last = 0;
+        for (int i = 0; i < frame.used; i++)
+        {
+            GLuint available = 0;
+            glGetQueryObjectuiv(frame.queries[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+            {
+                dropped += frame.used - i;
+                return;
+            }
+            GLuint64 start = 0, end = 0;
+            glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+            track->record(frame.sections[i].name, int64_t(start) + frame.cpuMinusGpu, int64_t(end) + frame.cpuMinusGpu);
+            first = std::min(first, start);
+            last = std::max(last, end);
+        }
+        if (last > first)
+            frameSeconds = double(last - first) * 1e-9;
+    }
+};
+
+#if PROFILING
+#define GPU_PROFILE_SCOPE(profiler, name) GpuProfiler::Scope PROFILE_CONCAT(gpuProfileScope, __LINE__)(profiler, name)
+#else
+#define GPU_PROFILE_SCOPE(profiler, name)
+#endif
@@ -0,0 +1,183 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdio>
+#include <cstddef>
+#include <algorithm>
+
+#include "Render/Shader.hpp"
+#include "Render/RenderStats.hpp"
+
+// Numbers drawn on top of the frame with the Text-Render pipeline. Graph bars and the panel are
+// instances of a solid layer in the glyph array, so the overlay costs one draw for the panel, one
+// for the graph and at most MAX_TEXT_DRAWS for the text, and it never allocates after construction.
+class PerfOverlay {
+public:
+    static constexpr int HISTORY = 120;        // frame times in the graph
+    static constexpr int BATCH = 240;          // Text-Render.vert holds 250 transforms
+    static constexpr int MAX_TEXT_DRAWS = 2;
+
+    struct Glyph {
+        glm::ivec2 bearing{ 0 };
+        unsigned int advance = 0; // 1/64 pixels
+    };
+
+    // what the overlay shows besides its own frame history
+    struct Sample {
+        RenderStats stats;
+        double cpuSeconds = 0.0;
+        double gpuSeconds = 0.0;
+        size_t textureBytes = 0;
+        size_t textureBudget = 0;
+        size_t shaderBytes = 0;
+    };
+
+private:
+    Glyph glyphs[128];
+    int solidLayer;
+    float history[HISTORY] = {};
+    int historyHead = 0;
+
+    glm::mat4 transforms[BATCH];
+    int letters[BATCH];
+    int count = 0;
+    char text[BATCH * MAX_TEXT_DRAWS];
+
+    GLint transformsLocation = -1, letterMapLocation = -1, colorLocation = -1, projectionLocation = -1;
+    GLuint locationsFor = 0;
+
+public:
+    // solidLayer is a layer of the glyph array that is fully covered, the bars are drawn with it
+    PerfOverlay(int solidLayer) : solidLayer(solidLayer) {}
+
+    void setGlyph(unsigned char c, glm::ivec2 bearing, unsigned int advance) {
+        if (c < 128)
+            glyphs[c] = { bearing, advance };
+    }
+
+    void addFrameTime(double seconds) {
+        history[historyHead] = float(seconds);
+        historyHead = (historyHead + 1) % HISTORY;
+    }
+
+    // Call after the frame's own draws so they are not counted; textShader is Text-Render
+    void draw(const Shader& textShader, GLuint quadVAO, GLuint glyphArray, int width, int height, const Sample& sample) {
+        if (locationsFor != textShader.ID)
+        {
+            transformsLocation = glGetUniformLocation(textShader.ID, "transforms");
+            letterMapLocation = glGetUniformLocation(textShader.ID, "letterMap");
+            colorLocation = glGetUniformLocation(textShader.ID, "textColor");
+            projectionLocation = glGetUniformLocation(textShader.ID, "projection");
+            locationsFor = textShader.ID;
+        }
+
+        float average = 0.0f, worst = 0.0f;
+        for (float seconds : history)
+        {
+            average += seconds;
+            worst = std::max(worst, seconds);
+        }
+        average /= HISTORY;
+        float last = history[(historyHead + HISTORY - 1) % HISTORY];
+
+        int length = std::snprintf(text, sizeof(text),
+            "Frame %6.2f ms  avg %6.2f  max %6.2f\n"
+            "CPU %6.2f ms  GPU %6.2f ms\n"
+            "Draws %u  State changes %u\n"
+            "Uploaded %.1f KB\n"
+            "Sprites %u  Glyphs %u\n"
+            "Textures %.1f / %.0f MB  Shaders %.0f KB",
+            last * 1000.0f, average * 1000.0f, worst * 1000.0f,
+            sample.cpuSeconds * 1000.0, sample.gpuSeconds * 1000.0,
+            sample.stats.drawCalls, sample.stats.stateChanges,
+            sample.stats.bytesUploaded / 1024.0,
+            sample.stats.sprites, sample.stats.glyphs,
+            sample.textureBytes / (1024.0 * 1024.0), sample.textureBudget / (1024.0 * 1024.0), sample.shaderBytes / 1024.0);
+        length = std::min(length, int(sizeof(text)) - 1);
+
+        const float scale = 0.35f * 48.0f / 256.0f; // same units as RenderText
+        const float lineHeight = 256.0f * 1.2f * scale;
+        const float margin = 8.0f;
+        const float graphHeight = 60.0f;
+        const float barWidth = 3.0f;
+
+        int lines = 1, column = 0, widest = 0;
+        for (int i = 0; i < length; i++)
+        {
+            column = text[i] == '\n' ? 0 : column + 1;
+            lines += text[i] == '\n';
+            widest = std::max(widest, column);
+        }
+        float charWidth = (glyphs['0'].advance >> 6) * scale;
+        float panelWidth = std::max(HISTORY * barWidth, widest * charWidth) + margin * 2.0f;
+        float panelHeight = graphHeight + lines * lineHeight + margin * 3.0f;
+        float left = margin;
+        float top = float(height) - margin;
+
+        glm::mat4 projection = glm::ortho(0.0f, float(width), 0.0f, float(height), -1.0f, 1.0f);
+        textShader.use();
+        glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, glm::value_ptr(projection));
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, glyphArray);
+        glBindVertexArray(quadVAO);
+
+        addQuad(left, top - panelHeight, panelWidth, panelHeight, solidLayer);
+        flush(glm::vec3(0.05f, 0.05f, 0.05f));
+
+        // oldest to newest, full height is 33.3 ms
+        float graphBottom = top - margin - graphHeight;
+        for (int i = 0; i < HISTORY; i++)
+        {
+            float seconds = history[(historyHead + i) % HISTORY];
+            float barHeight = std::max(1.0f, std::min(seconds / (1.0f / 30.0f), 1.0f) * graphHeight);
+            addQuad(left + margin + i * barWidth, graphBottom, barWidth - 1.0f, barHeight, solidLayer);
+        }
+        flush(glm::vec3(0.3f, 0.9f, 0.4f));
+
+        float x = left + margin;
+        float y = graphBottom - margin - lineHeight;
+        for (int i = 0; i < length; i++)
+        {
+            unsigned char c = (unsigned char)text[i];
+            if (c == '\n')
+            {
+                x = left + margin;
+                y -= lineHeight;
+                continue;
+            }
+            const Glyph& glyph = glyphs[c & 127];
+            if (c != ' ')
+            {
+                float size = 256.0f * scale;
+                addQuad(x + glyph.bearing.x * scale, y - (256 - glyph.bearing.y) * scale, size, size, int(c));
+                if (count == BATCH)
+                    flush(glm::vec3(1.0f));
+            }
+            x += (glyph.advance >> 6) * scale;
+        }
+        flush(glm::vec3(1.0f));
+
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+private:
+    void addQuad(float x, float y, float width, float height, int layer) {
+        transforms[count] = glm::translate(glm::mat4(1.0f), glm::vec3(x, y, 0.0f)) * glm::scale(glm::mat4(1.0f), glm::vec3(width, height, 0.0f));
+        letters[count] = layer;
+        count++;
+    }
+
+    void flush(const glm::vec3& color) {
+        if (count == 0)
+            return;
+        glUniform3f(colorLocation, color.x, color.y, color.z);
+        glUniformMatrix4fv(transformsLocation, count, GL_FALSE, glm::value_ptr(transforms[0]));
+        glUniform1iv(letterMapLocation, count, letters);
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+        count = 0;
+    }
+};
@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Per-frame counters filled in by the render thread's draw code and shown by the PerfOverlay.
+// A state change is any bind or program switch issued while drawing.
+struct RenderStats {
+    uint32_t drawCalls = 0;
+    uint32_t stateChanges = 0;
+    size_t bytesUploaded = 0;
+    uint32_t sprites = 0;
+    uint32_t glyphs = 0;
+
+    void reset() {
+        *this = RenderStats();
+    }
+};
@@ -0,0 +1,120 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <unordered_map>
+#include <filesystem>
+#include <cstdint>
+#include <iostream>
+
+#include "Render/Shader.hpp"
+#include "Render/Texture.hpp"
+#include "Render/TextureResidency.hpp"
+
+// Ref-counted handle to a registry owned resource. The GL object is released when the last copy goes away.
+template<typename T>
+using ResourceHandle = std::shared_ptr<T>;
+
+struct ResourceStats {
+    size_t count = 0;
+    size_t bytes = 0;
+};
+
+// Loads every texture and shader exactly once, keyed by a hash of the normalized path.
+// Handles must be dropped while the GL context is alive and before the registry is destroyed.
+class ResourceRegistry {
+private:
+    template<typename T>
+    struct Entry {
+        std::weak_ptr<T> resource;
+        std::string path;
+        size_t bytes;
+    };
+
+    std::unordered_map<uint64_t, Entry<Texture>> textures;
+    std::unordered_map<uint64_t, Entry<Shader>> shaders;
+    ResourceStats textureStats, shaderStats;
+    TextureResidency* residency;
+
+public:
+    // With a residency manager every loaded texture is tracked against its VRAM budget
+    ResourceRegistry(TextureResidency* residency = nullptr) : residency(residency) {}
+    ResourceRegistry(const ResourceRegistry&) = delete;
+    ResourceRegistry& operator=(const ResourceRegistry&) = delete;
+
+    ResourceHandle<Texture> loadTexture(const std::string& filepath) {
+        std::string path = normalize(filepath);
+        return acquire(textures, textureStats, hashPath(path), path, [&]() {
+            Texture* texture = new Texture(path);
+            if (residency)
+                texture->track(*residency);
+            return texture;
+        });
+    }
+
+    ResourceHandle<Shader> loadShader(const std::string& vertexPath, const std::string& fragmentPath) {
+        std::string vertex = normalize(vertexPath), fragment = normalize(fragmentPath);
+        uint64_t key = hashPath(vertex) ^ (hashPath(fragment) * 0x9E3779B97F4A7C15ull);
+        return acquire(shaders, shaderStats, key, vertex + "|" + fragment,
+            [&]() { return new Shader(vertex.c_str(), fragment.c_str()); });
+    }
+
+    const ResourceStats& textureMemory() const {
+        return textureStats;
+    }
+
+    const ResourceStats& shaderMemory() const {
+        return shaderStats;
+    }
+
+    void printStats() const {
+        std::cout << "Resources: " << textureStats.count << " textures (" << textureStats.bytes / 1024 << " KiB), "
+                  << shaderStats.count << " shaders (" << shaderStats.bytes / 1024 << " KiB)" << "\n";
+    }
+
+private:
+    // same file, same key: "./a/../b.png" and "b.png" resolve to one entry
+    static std::string normalize(const std::string& filepath) {
+        return std::filesystem::path(filepath).lexically_normal().generic_string();
+    }
+
+    // FNV-1a
+    static uint64_t hashPath(const std::string& path) {
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (char c : path)
+        {
+            hash ^= uint8_t(c);
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    template<typename T, typename Load>
+    ResourceHandle<T> acquire(std::unordered_map<uint64_t, Entry<T>>& entries, ResourceStats& stats, uint64_t key, const std::string& path, Load load) {
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            if (it->second.path == path)
+                return it->second.resource.lock();
+            // vanishingly rare, but never hand out the wrong asset: load it untracked instead
+            std::cout << "RESOURCE::Hash collision between " << it->second.path << " and " << path << "\n";
+            return ResourceHandle<T>(load(), [](T* object) {
+                object->cleanUp();
+                delete object;
+            });
+        }
+
+        ResourceHandle<T> resource(load(), [&entries, &stats, key](T* object) {
+            auto entry = entries.find(key);
+            stats.count--;
+            stats.bytes -= entry->second.bytes;
+            entries.erase(entry);
+            object->cleanUp();
+            delete object;
+        });
+        size_t bytes = resource->memoryBytes();
+        entries[key] = { resource, path, bytes };
+        stats.count++;
+        stats.bytes += bytes;
+        return resource;
+    }
+};
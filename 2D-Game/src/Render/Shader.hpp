@@ -76,6 +76,20 @@ public:
     {
         glUseProgram(ID);
     }
+    // release the program object
+    // ------------------------------------------------------------------------
+    void cleanUp() const
+    {
+        glDeleteProgram(ID);
+    }
+    // size of the linked program binary, a rough stand-in for the driver memory it holds
+    // ------------------------------------------------------------------------
+    size_t memoryBytes() const
+    {
+        GLint length = 0;
+        glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+        return size_t(length);
+    }
     // utility uniform functions
     // ------------------------------------------------------------------------
     void setBool(const std::string& name, bool value) const
@@ -0,0 +1,161 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+
+// Table of normalized frame rects (u0, v0, u1, v1) for one texture, uploaded once to an SSBO.
+// Sprites only store a 16 bit frame index, the vertex shader looks the rect up.
+//
+// Descriptor files are plain text, one directive per line, '#' starts a comment:
+//   size  <sheet width> <sheet height>
+//   grid  <cell width> <cell height> [columns rows]      adds every cell, row-major
+//   frame <name> <x> <y> <width> <height>               adds one named pixel rect
+class SpriteSheet {
+private:
+    std::vector<glm::vec4> frames;
+    std::unordered_map<std::string, uint16_t> names;
+    GLuint frameBuffer = 0;
+    int sheetWidth = 0, sheetHeight = 0;
+    int gridFirst = 0, gridColumns = 0, gridRows = 0; // cells of the last grid directive
+
+public:
+    SpriteSheet() = default;
+
+    SpriteSheet(const std::string& filepath) {
+        load(filepath);
+        upload();
+    }
+
+    bool load(const std::string& filepath) {
+        frames.clear();
+        names.clear();
+        sheetWidth = sheetHeight = 0;
+        gridFirst = gridColumns = gridRows = 0;
+        std::ifstream file(filepath);
+        if (!file)
+        {
+            std::cout << "Failed to load sprite sheet at " << filepath << "\n";
+            return false;
+        }
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(file, line))
+        {
+            lineNumber++;
+            line = line.substr(0, line.find('#'));
+            std::istringstream stream(line);
+            std::string directive;
+            if (!(stream >> directive))
+                continue;
+
+            if (directive == "size")
+                stream >> sheetWidth >> sheetHeight;
+            else if (directive == "grid")
+            {
+                int cellWidth = 0, cellHeight = 0, columns = 0, rows = 0;
+                stream >> cellWidth >> cellHeight;
+                if (!(stream >> columns >> rows) && cellWidth > 0 && cellHeight > 0)
+                {
+                    columns = sheetWidth / cellWidth;
+                    rows = sheetHeight / cellHeight;
+                }
+                gridFirst = int(frames.size());
+                gridColumns = std::max(columns, 0);
+                gridRows = std::max(rows, 0);
+                for (int y = 0; y < rows; y++)
+                    for (int x = 0; x < columns; x++)
+                        addFrame(x * cellWidth, y * cellHeight, cellWidth, cellHeight);
+            }
+            else if (directive == "frame")
+            {
+                std::string name;
+                int x, y, width, height;
+                if (stream >> name >> x >> y >> width >> height)
+                    addFrame(x, y, width, height, name);
+                else
+                    std::cout << "SPRITESHEET::" << filepath << ":" << lineNumber << " malformed frame" << "\n";
+            }
+            else
+                std::cout << "SPRITESHEET::" << filepath << ":" << lineNumber << " unknown directive " << directive << "\n";
+
+            if (sheetWidth <= 0 || sheetHeight <= 0)
+            {
+                std::cout << "SPRITESHEET::" << filepath << " must start with a size line" << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // pixel rect inside the sheet, needs the size to be known
+    uint16_t addFrame(int x, int y, int width, int height, const std::string& name = "") {
+        glm::vec4 uvRect(float(x) / sheetWidth, float(y) / sheetHeight, float(x + width) / sheetWidth, float(y + height) / sheetHeight);
+        return addFrame(uvRect, name);
+    }
+
+    // already normalized rect, e.g. an AtlasRegion
+    uint16_t addFrame(const glm::vec4& uvRect, const std::string& name = "") {
+        if (frames.size() > UINT16_MAX)
+        {
+            std::cout << "SPRITESHEET::Frame table is full" << "\n";
+            return 0;
+        }
+        uint16_t index = uint16_t(frames.size());
+        frames.push_back(uvRect);
+        if (!name.empty())
+            names[name] = index;
+        return index;
+    }
+
+    uint16_t frame(const std::string& name) const {
+        auto it = names.find(name);
+        if (it == names.end())
+        {
+            std::cout << "SPRITESHEET::No frame named " << name << "\n";
+            return 0;
+        }
+        return it->second;
+    }
+
+    // cell of the grid directive, frame 0 if the grid has no such cell
+    uint16_t frame(int column, int row) const {
+        size_t index = size_t(gridFirst) + size_t(row) * gridColumns + column;
+        if (column < 0 || column >= gridColumns || row < 0 || row >= gridRows || index >= frames.size())
+        {
+            std::cout << "SPRITESHEET::No grid cell " << column << ", " << row << "\n";
+            return 0;
+        }
+        return uint16_t(index);
+    }
+
+    size_t frameCount() const {
+        return frames.size();
+    }
+
+    // Frames added after this need another upload(). An empty table uploads one empty rect, so the
+    // frame 0 every failed lookup returns is always in the buffer.
+    void upload() {
+        if (frameBuffer)
+            glDeleteBuffers(1, &frameBuffer);
+        const glm::vec4 empty(0.0f);
+        glCreateBuffers(1, &frameBuffer);
+        glNamedBufferStorage(frameBuffer, std::max<size_t>(frames.size(), 1) * sizeof(glm::vec4), frames.empty() ? &empty : frames.data(), 0);
+    }
+
+    void bind(unsigned int binding) const {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, frameBuffer);
+    }
+
+    void cleanUp() {
+        glDeleteBuffers(1, &frameBuffer);
+        frameBuffer = 0;
+    }
+};
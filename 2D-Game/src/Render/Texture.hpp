@@ -3,50 +3,185 @@
 #include <GLFW/glfw3.h>
 #include <STB/stb_image.h>
 #include <string>
+#include <algorithm>
+#include <chrono>
 
 #include <iostream>
 
+#include "Render/CompressedTexture.hpp"
+#include "Render/TextureResidency.hpp"
+
 
 class Texture {
 private:
-    GLuint textureID;
-    int width, height, nrChannels;
+    GLuint textureID = 0;
+    int width = 0, height = 0, nrChannels = 0;
+    size_t residentBytes = 0;
+    std::string path;
+    bool flipVertically;
+    bool failed = false;    // the file could not be loaded, binds use texture 0 instead of retrying
+    TextureResidency* residency = nullptr;
+    TextureResidency::Handle residencyHandle;
 
 public:
-    Texture(std::string filepath) {
+    Texture(std::string filepath, bool flipVertically = false) : path(filepath), flipVertically(flipVertically) {
+        failed = !load();
+    }
+
+    // Hands VRAM management to a residency manager, which may evict this texture between frames
+    void track(TextureResidency& manager) {
+        residency = &manager;
+        residencyHandle = manager.track(residentBytes, [this]() { glDeleteTextures(1, &textureID); textureID = 0; });
+    }
+
+    bool isResident() const {
+        return textureID != 0;
+    }
+
+    // Reloads an evicted texture ahead of use so the next bind does not stall
+    void makeResident() {
+        if (residency && !isResident() && !failed)
+            reload(false);
+    }
+
+    void cleanUp() {
+        if (residency)
+            residency->untrack(residencyHandle);
+        residency = nullptr;
+        glDeleteTextures(1, &textureID);
+        textureID = 0;
+    }
+
+    // Estimated VRAM held by this texture, all mip levels included
+    size_t memoryBytes() const {
+        return residentBytes;
+    }
+
+    void bind(unsigned int slot) {
+        if (residency)
+        {
+            if (!isResident() && !failed)
+                reload(true);
+            residency->touch(residencyHandle);
+        }
+        glBindTextureUnit(slot, textureID);
+    }
+
+private:
+    // false when the file is missing or unreadable, textureID stays 0
+    bool load() {
+        const std::string& filepath = path;
+        residentBytes = 0;
+        if (filepath.size() > 5 && filepath.compare(filepath.size() - 5, 5, ".ctex") == 0)
+            return loadCompressed(filepath);
+
+        // set every time, a reload after eviction must not pick up whatever the last loader left behind
+        stbi_set_flip_vertically_on_load(flipVertically);
         unsigned char* data;
         data = stbi_load(filepath.c_str(), &width, &height, &nrChannels, 0);
         if (!data)
         {
             std::string error = "Failed to load texture at " + filepath;
-            std::cout << error << "/n";
+            std::cout << error << "\n";
+            return false;
         }
 
-        GLint format = GL_RGB;
-        if (nrChannels == 4)
-            format = GL_RGBA;
-        if (nrChannels == 1)
+        // sized internal format matching what is actually in the file, grey images are swizzled back to grey
+        GLenum internalFormat = GL_RGBA8, format = GL_RGBA;
+        GLint swizzle[4] = { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA };
+        switch (nrChannels)
+        {
+        case 1:
+            internalFormat = GL_R8;
             format = GL_RED;
+            swizzle[1] = swizzle[2] = GL_RED;
+            swizzle[3] = GL_ONE;
+            break;
+        case 2:
+            internalFormat = GL_RG8;
+            format = GL_RG;
+            swizzle[1] = swizzle[2] = GL_RED;
+            swizzle[3] = GL_GREEN;
+            break;
+        case 3:
+            internalFormat = GL_RGB8;
+            format = GL_RGB;
+            break;
+        }
+
+        GLsizei levels = mipLevels(width, height);
+        glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+        setSamplerState(levels);
+        glTextureParameteriv(textureID, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+        glTextureStorage2D(textureID, levels, internalFormat, width, height);
 
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-       // glGenerateMipmap(GL_TEXTURE_2D);
+        // RGB and RG rows are not always 4 byte aligned
+        GLint alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTextureSubImage2D(textureID, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+        glGenerateTextureMipmap(textureID);
+
+        size_t texelBytes = nrChannels == 3 ? 4 : nrChannels; // drivers pad RGB8 to 32 bits
+        for (GLsizei i = 0; i < levels; i++)
+            residentBytes += size_t(std::max(1, width >> i)) * std::max(1, height >> i) * texelBytes;
         stbi_image_free(data);
-        stbi_set_flip_vertically_on_load(true);
+        return true;
+    }
+
+    // A file that has gone missing since the first load is not retried on every bind
+    void reload(bool stall) {
+        auto start = std::chrono::steady_clock::now();
+        if (!load())
+        {
+            failed = true;
+            return;
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        residency->reloaded(residencyHandle, residentBytes, elapsed.count(), stall);
+    }
 
+    // full chain down to 1x1
+    static GLsizei mipLevels(int width, int height) {
+        GLsizei levels = 1;
+        while ((width | height) >> levels)
+            levels++;
+        return levels;
     }
 
-    void cleanUp() const {
-        glDeleteTextures(1, &textureID);
+    void setSamplerState(GLsizei levels) const {
+        glTextureParameteri(textureID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTextureParameteri(textureID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTextureParameteri(textureID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(textureID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTextureParameteri(textureID, GL_TEXTURE_MAX_LEVEL, levels - 1);
     }
 
-    void bind(unsigned int slot) {
-        glActiveTexture(GL_TEXTURE0 + slot);
-        glBindTexture(GL_TEXTURE_2D, textureID);
+    // Uploads the pre-encoded mip chain straight out of the mapped file, no decode and no copy
+    bool loadCompressed(const std::string& filepath) {
+        MappedFile file(filepath);
+        const CompressedMipLevel* levels = nullptr;
+        const CompressedTextureHeader* header = file.isOpen() ? readCompressedTexture(file, levels) : nullptr;
+        if (!header)
+        {
+            std::cout << "Failed to load compressed texture at " << filepath << "\n";
+            return false;
+        }
+        width = int(header->width);
+        height = int(header->height);
+        nrChannels = 4;
+
+        GLenum internalFormat = blockGLFormat(header->format);
+        glCreateTextures(GL_TEXTURE_2D, 1, &textureID);
+        setSamplerState(GLsizei(header->mipCount));
+        glTextureStorage2D(textureID, GLsizei(header->mipCount), internalFormat, width, height);
+        for (uint32_t i = 0; i < header->mipCount; i++)
+        {
+            residentBytes += size_t(levels[i].size);
+            glCompressedTextureSubImage2D(textureID, GLint(i), 0, 0, levels[i].width, levels[i].height, internalFormat,
+                GLsizei(levels[i].size), file.data() + levels[i].offset);
+        }
+        return true;
     }
 };
\ No newline at end of file
@@ -0,0 +1,357 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <STB/stb_image.h>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <climits>
+#include <iostream>
+
+// Pixel rectangle inside an atlas page
+struct AtlasRect {
+    int x, y, width, height;
+};
+
+// Where a packed image ended up: page index plus normalized UVs (u0, v0, u1, v1)
+struct AtlasRegion {
+    int page;
+    glm::vec4 uvRect;
+    glm::ivec2 size;
+};
+
+// MaxRects bin packer using the best-short-side-fit heuristic
+class MaxRectsPacker {
+private:
+    std::vector<AtlasRect> freeRects;
+
+public:
+    MaxRectsPacker(int width, int height) {
+        freeRects.push_back({ 0, 0, width, height });
+    }
+
+    bool insert(int width, int height, AtlasRect& out) {
+        int bestShortSide = INT_MAX, bestLongSide = INT_MAX;
+        bool found = false;
+        for (const AtlasRect& free : freeRects)
+        {
+            if (free.width < width || free.height < height)
+                continue;
+            int leftoverX = free.width - width;
+            int leftoverY = free.height - height;
+            int shortSide = std::min(leftoverX, leftoverY);
+            int longSide = std::max(leftoverX, leftoverY);
+            if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+            {
+                out = { free.x, free.y, width, height };
+                bestShortSide = shortSide;
+                bestLongSide = longSide;
+                found = true;
+            }
+        }
+        if (!found)
+            return false;
+
+        // split every free rect the new one overlaps, then drop the ones contained in others
+        std::vector<AtlasRect> kept;
+        kept.reserve(freeRects.size() + 4);
+        for (const AtlasRect& free : freeRects)
+            if (!splitFreeRect(free, out, kept))
+                kept.push_back(free);
+        freeRects.swap(kept);
+        pruneFreeRects();
+        return true;
+    }
+
+private:
+    static bool splitFreeRect(const AtlasRect& free, const AtlasRect& used, std::vector<AtlasRect>& freeRects) {
+        if (used.x >= free.x + free.width || used.x + used.width <= free.x ||
+            used.y >= free.y + free.height || used.y + used.height <= free.y)
+            return false;
+
+        if (used.x > free.x)
+            freeRects.push_back({ free.x, free.y, used.x - free.x, free.height });
+        if (used.x + used.width < free.x + free.width)
+            freeRects.push_back({ used.x + used.width, free.y, free.x + free.width - (used.x + used.width), free.height });
+        if (used.y > free.y)
+            freeRects.push_back({ free.x, free.y, free.width, used.y - free.y });
+        if (used.y + used.height < free.y + free.height)
+            freeRects.push_back({ free.x, used.y + used.height, free.width, free.y + free.height - (used.y + used.height) });
+        return true;
+    }
+
+    static bool contains(const AtlasRect& a, const AtlasRect& b) {
+        return b.x >= a.x && b.y >= a.y && b.x + b.width <= a.x + a.width && b.y + b.height <= a.y + a.height;
+    }
+
+    void pruneFreeRects() {
+        for (size_t i = 0; i < freeRects.size(); i++)
+        {
+            for (size_t j = i + 1; j < freeRects.size();)
+            {
+                if (contains(freeRects[j], freeRects[i]))
+                {
+                    freeRects.erase(freeRects.begin() + i);
+                    i--;
+                    break;
+                }
+                if (contains(freeRects[i], freeRects[j]))
+                    freeRects.erase(freeRects.begin() + j);
+                else
+                    j++;
+            }
+        }
+    }
+};
+
+// Packs loose RGBA images into a few large pages so many sprites can share one bind and one draw.
+// Images are queued with add(), packed and uploaded by build(). save()/load() bake the result
+// into a single binary file so the packing can also be done as an offline step.
+// Library only for now: the game's sprites all come from one prebuilt sheet. A page is drawn by
+// binding it in place of the sheet and adding each region's uvRect through SpriteSheet::addFrame.
+class TextureAtlas {
+public:
+    static constexpr int MAX_PAGE_SIZE = 16384; // GL_MAX_TEXTURE_SIZE of current desktop parts
+
+private:
+    struct PendingImage {
+        std::string name;
+        int width, height;
+        std::vector<unsigned char> pixels;
+    };
+
+    int pageSize, padding, extrude;
+    std::vector<PendingImage> pending;
+    std::vector<MaxRectsPacker> packers;
+    std::vector<std::vector<unsigned char>> pagePixels;
+    std::vector<GLuint> pages;
+    std::unordered_map<std::string, AtlasRegion> regions;
+
+public:
+    TextureAtlas(int pageSize = 2048, int padding = 2, int extrude = 1)
+        : pageSize(pageSize), padding(padding), extrude(extrude) {}
+
+    bool add(const std::string& name, const std::string& filepath) {
+        int width, height, nrChannels;
+        unsigned char* data = stbi_load(filepath.c_str(), &width, &height, &nrChannels, 4);
+        if (!data)
+        {
+            std::cout << "Failed to load atlas image at " << filepath << "\n";
+            return false;
+        }
+        add(name, data, width, height);
+        stbi_image_free(data);
+        return true;
+    }
+
+    // rgba must hold width * height * 4 bytes
+    void add(const std::string& name, const unsigned char* rgba, int width, int height) {
+        pending.push_back({ name, width, height, std::vector<unsigned char>(rgba, rgba + size_t(width) * height * 4) });
+    }
+
+    // Packs every queued image and uploads the pages. Images that do not fit an empty page are skipped.
+    // Calling build() again packs newly queued images into the free space left on existing pages.
+    void build() {
+        // largest first packs noticeably tighter with MaxRects
+        std::sort(pending.begin(), pending.end(), [](const PendingImage& a, const PendingImage& b) {
+            return std::max(a.width, a.height) > std::max(b.width, b.height);
+        });
+
+        for (const PendingImage& image : pending)
+        {
+            int w = image.width + 2 * extrude + padding;
+            int h = image.height + 2 * extrude + padding;
+            if (w > pageSize || h > pageSize)
+            {
+                std::cout << "ATLAS::Image " << image.name << " is larger than an atlas page" << "\n";
+                continue;
+            }
+
+            AtlasRect rect;
+            int page = -1;
+            for (size_t i = 0; i < packers.size() && page < 0; i++)
+                if (packers[i].insert(w, h, rect))
+                    page = int(i);
+            if (page < 0)
+            {
+                packers.emplace_back(pageSize, pageSize);
+                pagePixels.emplace_back(size_t(pageSize) * pageSize * 4, 0);
+                packers.back().insert(w, h, rect);
+                page = int(packers.size()) - 1;
+            }
+
+            blit(pagePixels[page], image, rect.x + extrude, rect.y + extrude);
+            AtlasRegion region;
+            region.page = page;
+            region.size = glm::ivec2(image.width, image.height);
+            region.uvRect = glm::vec4(
+                float(rect.x + extrude) / pageSize, float(rect.y + extrude) / pageSize,
+                float(rect.x + extrude + image.width) / pageSize, float(rect.y + extrude + image.height) / pageSize);
+            regions[image.name] = region;
+        }
+        pending.clear();
+        upload();
+    }
+
+    const AtlasRegion* find(const std::string& name) const {
+        auto it = regions.find(name);
+        return it == regions.end() ? nullptr : &it->second;
+    }
+
+    int pageCount() const {
+        return int(pages.size());
+    }
+
+    void bind(int page, unsigned int slot) const {
+        glBindTextureUnit(slot, pages[page]);
+    }
+
+    // Writes the packed pages and the region table so load() can skip decoding and packing
+    bool save(const std::string& filepath) const {
+        std::ofstream file(filepath, std::ios::binary);
+        if (!file)
+        {
+            std::cout << "ATLAS::Failed to open " << filepath << " for writing" << "\n";
+            return false;
+        }
+        const char magic[4] = { 'A', 'T', 'L', '1' };
+        file.write(magic, 4);
+        writeValue(file, pageSize);
+        writeValue(file, int(pagePixels.size()));
+        writeValue(file, int(regions.size()));
+        for (const auto& [name, region] : regions)
+        {
+            writeValue(file, int(name.size()));
+            file.write(name.data(), name.size());
+            writeValue(file, region);
+        }
+        for (const auto& pixels : pagePixels)
+            file.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+        return bool(file);
+    }
+
+    // Replaces the atlas with a baked one. Every count in the file is checked against what is
+    // left of it, so a truncated or garbage file fails without touching the current pages.
+    bool load(const std::string& filepath) {
+        std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+        char magic[4];
+        std::streamoff fileSize = file ? std::streamoff(file.tellg()) : 0;
+        file.seekg(0);
+        if (!file || !file.read(magic, 4) || std::memcmp(magic, "ATL1", 4) != 0)
+        {
+            std::cout << "ATLAS::Failed to load baked atlas at " << filepath << "\n";
+            return false;
+        }
+        auto remaining = [&]() { return fileSize - std::streamoff(file.tellg()); };
+        auto fail = [&](const char* what) {
+            std::cout << "ATLAS::Baked atlas " << filepath << " " << what << "\n";
+            return false;
+        };
+
+        int loadedPageSize = 0, pageCount = 0, regionCount = 0;
+        if (!readValue(file, loadedPageSize) || !readValue(file, pageCount) || !readValue(file, regionCount))
+            return fail("is truncated");
+        if (loadedPageSize <= 0 || loadedPageSize > MAX_PAGE_SIZE || pageCount < 0 || regionCount < 0)
+            return fail("has a bad header");
+        size_t pageBytes = size_t(loadedPageSize) * loadedPageSize * 4;
+        // each region is at least its length and its AtlasRegion
+        if (std::streamoff(regionCount) > remaining() / std::streamoff(sizeof(int) + sizeof(AtlasRegion)))
+            return fail("is truncated");
+
+        std::unordered_map<std::string, AtlasRegion> loadedRegions;
+        loadedRegions.reserve(size_t(regionCount));
+        for (int i = 0; i < regionCount; i++)
+        {
+            int length = 0;
+            if (!readValue(file, length) || length < 0 || std::streamoff(length) > remaining())
+                return fail("has a bad region name");
+            std::string name(size_t(length), '\0');
+            AtlasRegion region;
+            if (!file.read(name.data(), length) || !readValue(file, region))
+                return fail("is truncated");
+            if (region.page < 0 || region.page >= pageCount)
+                return fail("has a region outside its pages");
+            loadedRegions[name] = region;
+        }
+        if (pageBytes == 0 || std::streamoff(pageCount) > remaining() / std::streamoff(pageBytes))
+            return fail("is truncated");
+        std::vector<std::vector<unsigned char>> loadedPixels(size_t(pageCount), std::vector<unsigned char>(pageBytes, 0));
+        for (auto& pixels : loadedPixels)
+            if (!file.read(reinterpret_cast<char*>(pixels.data()), std::streamsize(pixels.size())))
+                return fail("is truncated");
+
+        cleanUp();
+        pageSize = loadedPageSize;
+        regions = std::move(loadedRegions);
+        pagePixels = std::move(loadedPixels);
+        // the free lists are not baked, so loaded pages are treated as full
+        packers.assign(size_t(pageCount), MaxRectsPacker(0, 0));
+        upload();
+        return true;
+    }
+
+    void cleanUp() {
+        glDeleteTextures(GLsizei(pages.size()), pages.data());
+        pages.clear();
+        packers.clear();
+        pagePixels.clear();
+        regions.clear();
+    }
+
+private:
+    // copies the image and smears its outermost texels `extrude` pixels outwards so
+    // linear filtering at the region edge never picks up a neighbour
+    void blit(std::vector<unsigned char>& page, const PendingImage& image, int dstX, int dstY) const {
+        for (int y = -extrude; y < image.height + extrude; y++)
+        {
+            int srcY = std::clamp(y, 0, image.height - 1);
+            for (int x = -extrude; x < image.width + extrude; x++)
+            {
+                int srcX = std::clamp(x, 0, image.width - 1);
+                const unsigned char* src = &image.pixels[(size_t(srcY) * image.width + srcX) * 4];
+                unsigned char* dst = &page[(size_t(dstY + y) * pageSize + (dstX + x)) * 4];
+                std::memcpy(dst, src, 4);
+            }
+        }
+    }
+
+    // Immutable storage with mips like Texture, but the chain stops while a level still keeps the
+    // gutter between two regions (extrude on both sides plus padding) at least a texel wide; past
+    // that a level averages neighbouring sprites into each other.
+    void upload() {
+        glDeleteTextures(GLsizei(pages.size()), pages.data());
+        pages.assign(pagePixels.size(), 0);
+        if (pages.empty())
+            return;
+        GLsizei levels = 1;
+        while ((pageSize >> levels) > 0 && ((2 * extrude + padding) >> levels) > 0)
+            levels++;
+        glCreateTextures(GL_TEXTURE_2D, GLsizei(pages.size()), pages.data());
+        for (size_t i = 0; i < pages.size(); i++)
+        {
+            glTextureParameteri(pages[i], GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(pages[i], GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTextureParameteri(pages[i], GL_TEXTURE_MIN_FILTER, levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            glTextureParameteri(pages[i], GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTextureParameteri(pages[i], GL_TEXTURE_MAX_LEVEL, levels - 1);
+            glTextureStorage2D(pages[i], levels, GL_RGBA8, pageSize, pageSize);
+            glTextureSubImage2D(pages[i], 0, 0, 0, pageSize, pageSize, GL_RGBA, GL_UNSIGNED_BYTE, pagePixels[i].data());
+            if (levels > 1)
+                glGenerateTextureMipmap(pages[i]);
+        }
+    }
+
+    template<typename T>
+    static void writeValue(std::ofstream& file, const T& value) {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    static bool readValue(std::ifstream& file, T& value) {
+        return bool(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+};
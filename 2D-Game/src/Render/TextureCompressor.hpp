@@ -0,0 +1,360 @@
+#pragma once
+#include <STB/stb_image.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "Render/CompressedTexture.hpp"
+
+// Offline converter from any stb_image readable file to a mipmapped .ctex.
+// The encoders favour speed over quality: endpoints come from the block's bounding box,
+// which is good enough for pixel art and keeps a full spritesheet under a second.
+namespace TextureCompressor {
+
+    struct Image {
+        int width, height;
+        std::vector<unsigned char> rgba;
+    };
+
+    // 2x2 box filter, odd edges are clamped
+    inline Image downsample(const Image& src) {
+        Image dst;
+        dst.width = std::max(1, src.width / 2);
+        dst.height = std::max(1, src.height / 2);
+        dst.rgba.resize(size_t(dst.width) * dst.height * 4);
+        for (int y = 0; y < dst.height; y++)
+        {
+            int y0 = std::min(y * 2, src.height - 1), y1 = std::min(y * 2 + 1, src.height - 1);
+            for (int x = 0; x < dst.width; x++)
+            {
+                int x0 = std::min(x * 2, src.width - 1), x1 = std::min(x * 2 + 1, src.width - 1);
+                for (int c = 0; c < 4; c++)
+                {
+                    int sum = src.rgba[(size_t(y0) * src.width + x0) * 4 + c] + src.rgba[(size_t(y0) * src.width + x1) * 4 + c] +
+                              src.rgba[(size_t(y1) * src.width + x0) * 4 + c] + src.rgba[(size_t(y1) * src.width + x1) * 4 + c];
+                    dst.rgba[(size_t(y) * dst.width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+        return dst;
+    }
+
+    // gathers a 4x4 block, clamping reads past the edge of small mips
+    inline void fetchBlock(const Image& image, int bx, int by, unsigned char block[16][4]) {
+        for (int y = 0; y < 4; y++)
+            for (int x = 0; x < 4; x++)
+            {
+                int sx = std::min(bx * 4 + x, image.width - 1);
+                int sy = std::min(by * 4 + y, image.height - 1);
+                std::memcpy(block[y * 4 + x], &image.rgba[(size_t(sy) * image.width + sx) * 4], 4);
+            }
+    }
+
+    inline uint16_t to565(const int c[3]) {
+        return uint16_t(((c[0] * 31 + 127) / 255) << 11 | ((c[1] * 63 + 127) / 255) << 5 | ((c[2] * 31 + 127) / 255));
+    }
+
+    inline void from565(uint16_t v, int c[3]) {
+        c[0] = ((v >> 11) & 31) * 255 / 31;
+        c[1] = ((v >> 5) & 63) * 255 / 63;
+        c[2] = (v & 31) * 255 / 31;
+    }
+
+    inline int colorDistance(const int a[3], const unsigned char b[4]) {
+        int dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+        return dr * dr + dg * dg + db * db;
+    }
+
+    // BC1 colour block. With punchThrough, texels under half alpha use the 3 colour + transparent mode.
+    inline void encodeColorBlock(unsigned char block[16][4], bool punchThrough, unsigned char* out) {
+        int lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+        bool transparent = false;
+        for (int i = 0; i < 16; i++)
+        {
+            if (punchThrough && block[i][3] < 128)
+            {
+                transparent = true;
+                continue;
+            }
+            for (int c = 0; c < 3; c++)
+            {
+                lo[c] = std::min(lo[c], int(block[i][c]));
+                hi[c] = std::max(hi[c], int(block[i][c]));
+            }
+        }
+        if (lo[0] > hi[0])
+            std::copy(lo, lo + 3, hi);
+
+        // pull the endpoints in by 1/16 of the range, the bounding box corners are rarely the best fit
+        for (int c = 0; c < 3; c++)
+        {
+            int inset = (hi[c] - lo[c]) / 16;
+            lo[c] += inset;
+            hi[c] -= inset;
+        }
+
+        uint16_t c0 = to565(hi), c1 = to565(lo);
+        // four colour mode needs c0 > c1, three colour + transparent needs c0 <= c1
+        if ((c0 < c1) != transparent && c0 != c1)
+            std::swap(c0, c1);
+        int palette[4][3];
+        from565(c0, palette[0]);
+        from565(c1, palette[1]);
+        bool fourColor = c0 > c1;
+        for (int c = 0; c < 3; c++)
+        {
+            if (fourColor)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+
+        uint32_t indices = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0;
+            if (!fourColor && punchThrough && block[i][3] < 128)
+                best = 3;
+            else
+            {
+                int bestDistance = INT32_MAX;
+                for (int p = 0; p < (fourColor ? 4 : 3); p++)
+                {
+                    int distance = colorDistance(palette[p], block[i]);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+            }
+            indices |= uint32_t(best) << (i * 2);
+        }
+        out[0] = uint8_t(c0); out[1] = uint8_t(c0 >> 8);
+        out[2] = uint8_t(c1); out[3] = uint8_t(c1 >> 8);
+        std::memcpy(out + 4, &indices, 4);
+    }
+
+    // BC3 alpha block, always the 8 value mode
+    inline void encodeAlphaBlock(unsigned char block[16][4], unsigned char* out) {
+        int a0 = 0, a1 = 255;
+        for (int i = 0; i < 16; i++)
+        {
+            a0 = std::max(a0, int(block[i][3]));
+            a1 = std::min(a1, int(block[i][3]));
+        }
+        int palette[8] = { a0, a1 };
+        for (int i = 1; i < 7; i++)
+            palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+
+        uint64_t indices = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, bestDistance = 256;
+            for (int p = 0; p < 8; p++)
+            {
+                int distance = std::abs(palette[p] - block[i][3]);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= uint64_t(best) << (i * 3);
+        }
+        out[0] = uint8_t(a0);
+        out[1] = uint8_t(a1);
+        for (int i = 0; i < 6; i++)
+            out[2 + i] = uint8_t(indices >> (i * 8));
+    }
+
+    // BC7 mode 6 only: one subset, 7 bit RGBA endpoints with a p-bit each and 4 bit indices
+    inline void encodeBC7Block(unsigned char block[16][4], unsigned char* out) {
+        static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        int endpoints[2][4], quantized[2][4], pbits[2];
+        for (int c = 0; c < 4; c++)
+        {
+            endpoints[0][c] = 255;
+            endpoints[1][c] = 0;
+        }
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 4; c++)
+            {
+                endpoints[0][c] = std::min(endpoints[0][c], int(block[i][c]));
+                endpoints[1][c] = std::max(endpoints[1][c], int(block[i][c]));
+            }
+
+        // pick the p-bit that reconstructs each endpoint with the smaller error
+        int unpacked[2][4];
+        for (int e = 0; e < 2; e++)
+        {
+            int bestError = INT32_MAX;
+            for (int p = 0; p < 2; p++)
+            {
+                int error = 0, q[4];
+                for (int c = 0; c < 4; c++)
+                {
+                    q[c] = std::clamp((endpoints[e][c] - p + 1) / 2, 0, 127);
+                    int value = (q[c] << 1) | p;
+                    error += (value - endpoints[e][c]) * (value - endpoints[e][c]);
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    pbits[e] = p;
+                    std::copy(q, q + 4, quantized[e]);
+                }
+            }
+            for (int c = 0; c < 4; c++)
+                unpacked[e][c] = (quantized[e][c] << 1) | pbits[e];
+        }
+
+        int indices[16];
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, bestError = INT32_MAX;
+            for (int w = 0; w < 16; w++)
+            {
+                int error = 0;
+                for (int c = 0; c < 4; c++)
+                {
+                    int value = ((64 - weights[w]) * unpacked[0][c] + weights[w] * unpacked[1][c] + 32) >> 6;
+                    error += (value - block[i][c]) * (value - block[i][c]);
+                }
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = w;
+                }
+            }
+            indices[i] = best;
+        }
+
+        // the anchor index is stored with its top bit implied zero
+        if (indices[0] & 8)
+        {
+            for (int c = 0; c < 4; c++)
+                std::swap(quantized[0][c], quantized[1][c]);
+            std::swap(pbits[0], pbits[1]);
+            for (int i = 0; i < 16; i++)
+                indices[i] = 15 - indices[i];
+        }
+
+        uint64_t bits[2] = { 0, 0 };
+        int position = 0;
+        auto put = [&](uint64_t value, int count) {
+            for (int i = 0; i < count; i++, position++)
+                bits[position / 64] |= ((value >> i) & 1) << (position % 64);
+        };
+        put(1 << 6, 7);
+        for (int c = 0; c < 4; c++)
+        {
+            put(quantized[0][c], 7);
+            put(quantized[1][c], 7);
+        }
+        put(pbits[0], 1);
+        put(pbits[1], 1);
+        put(indices[0], 3);
+        for (int i = 1; i < 16; i++)
+            put(indices[i], 4);
+        std::memcpy(out, bits, 16);
+    }
+
+    inline std::vector<unsigned char> encodeLevel(const Image& image, BlockFormat format) {
+        int blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+        std::vector<unsigned char> data(size_t(blocksX) * blocksY * blockBytes(format));
+        unsigned char* out = data.data();
+        unsigned char block[16][4];
+        for (int by = 0; by < blocksY; by++)
+            for (int bx = 0; bx < blocksX; bx++)
+            {
+                fetchBlock(image, bx, by, block);
+                switch (format)
+                {
+                case BlockFormat::BC1:
+                    encodeColorBlock(block, true, out);
+                    break;
+                case BlockFormat::BC3:
+                    encodeAlphaBlock(block, out);
+                    encodeColorBlock(block, false, out + 8);
+                    break;
+                case BlockFormat::BC7:
+                    encodeBC7Block(block, out);
+                    break;
+                }
+                out += blockBytes(format);
+            }
+        return data;
+    }
+
+    // Encodes inputPath and every mip level down to 1x1 into outputPath
+    inline bool compressFile(const std::string& inputPath, const std::string& outputPath, BlockFormat format) {
+        Image image;
+        int nrChannels;
+        unsigned char* pixels = stbi_load(inputPath.c_str(), &image.width, &image.height, &nrChannels, 4);
+        if (!pixels)
+        {
+            std::cout << "Failed to load texture at " << inputPath << "\n";
+            return false;
+        }
+        image.rgba.assign(pixels, pixels + size_t(image.width) * image.height * 4);
+        stbi_image_free(pixels);
+
+        std::vector<std::vector<unsigned char>> levels;
+        std::vector<CompressedMipLevel> table;
+        while (true)
+        {
+            levels.push_back(encodeLevel(image, format));
+            table.push_back({ 0, levels.back().size(), uint32_t(image.width), uint32_t(image.height) });
+            if (image.width == 1 && image.height == 1)
+                break;
+            image = downsample(image);
+        }
+
+        CompressedTextureHeader header;
+        std::memcpy(header.magic, COMPRESSED_TEXTURE_MAGIC, 4);
+        header.version = COMPRESSED_TEXTURE_VERSION;
+        header.format = format;
+        header.width = table[0].width;
+        header.height = table[0].height;
+        header.mipCount = uint32_t(table.size());
+
+        uint64_t offset = sizeof(header) + table.size() * sizeof(CompressedMipLevel);
+        for (auto& level : table)
+        {
+            offset = (offset + 15) & ~uint64_t(15);
+            level.offset = offset;
+            offset += level.size;
+        }
+
+        std::ofstream file(outputPath, std::ios::binary);
+        if (!file)
+        {
+            std::cout << "Failed to open " << outputPath << " for writing" << "\n";
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(CompressedMipLevel));
+        for (size_t i = 0; i < levels.size(); i++)
+        {
+            static const char zeros[16] = {};
+            file.write(zeros, std::streamsize(table[i].offset - uint64_t(file.tellp())));
+            file.write(reinterpret_cast<const char*>(levels[i].data()), levels[i].size());
+        }
+        std::cout << "Compressed " << inputPath << " (" << header.width << "x" << header.height << ", "
+                  << header.mipCount << " mips) to " << outputPath << "\n";
+        return bool(file);
+    }
+}
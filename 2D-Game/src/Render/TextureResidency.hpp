@@ -0,0 +1,120 @@
+#pragma once
+#include <list>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+
+// Keeps the estimated VRAM of tracked textures under a budget. Every bind marks a texture as used
+// in the current frame; at the end of a frame the least recently used textures are evicted until
+// the budget holds again. Evicted textures reload themselves the next time they are bound.
+class TextureResidency {
+public:
+    struct Entry {
+        std::function<void()> evict;
+        size_t bytes;
+        uint64_t lastUsedFrame;
+        bool resident;
+    };
+    using Handle = std::list<Entry>::iterator;
+
+    struct Stats {
+        uint64_t evictions = 0;
+        uint64_t reloads = 0;
+        uint64_t stalls = 0;      // reloads that happened inside bind(), i.e. while a draw was waiting
+        double stallSeconds = 0.0;
+    };
+
+private:
+    std::list<Entry> resident; // most recently used at the front
+    std::list<Entry> evicted;
+    size_t budgetBytes;
+    size_t residentBytes = 0;
+    uint64_t frame = 0;
+    Stats stats;
+
+public:
+    TextureResidency(size_t budgetBytes) : budgetBytes(budgetBytes) {}
+    TextureResidency(const TextureResidency&) = delete;
+    TextureResidency& operator=(const TextureResidency&) = delete;
+
+    // Registers a texture that is currently resident. evict must free its GL storage.
+    Handle track(size_t bytes, std::function<void()> evict) {
+        resident.push_front({ std::move(evict), bytes, frame, true });
+        residentBytes += bytes;
+        return resident.begin();
+    }
+
+    void untrack(Handle handle) {
+        if (handle->resident)
+        {
+            residentBytes -= handle->bytes;
+            resident.erase(handle);
+        }
+        else
+            evicted.erase(handle);
+    }
+
+    void touch(Handle handle) {
+        handle->lastUsedFrame = frame;
+        if (handle->resident)
+            resident.splice(resident.begin(), resident, handle);
+    }
+
+    // The texture has uploaded its data again; stall is true when a bind had to wait for it.
+    // Ignored for a texture that was never evicted, the handle is already on the resident list.
+    void reloaded(Handle handle, size_t bytes, double seconds, bool stall) {
+        if (handle->resident)
+            return;
+        handle->bytes = bytes;
+        handle->resident = true;
+        handle->lastUsedFrame = frame;
+        resident.splice(resident.begin(), evicted, handle);
+        residentBytes += bytes;
+        stats.reloads++;
+        if (stall)
+        {
+            stats.stalls++;
+            stats.stallSeconds += seconds;
+        }
+    }
+
+    // Call once per frame after the last draw
+    void endFrame() {
+        trim();
+        frame++;
+    }
+
+    // Evicts from the cold end, never anything bound during the current frame
+    void trim() {
+        while (residentBytes > budgetBytes && !resident.empty() && resident.back().lastUsedFrame < frame)
+        {
+            Handle victim = std::prev(resident.end());
+            victim->resident = false;
+            residentBytes -= victim->bytes;
+            evicted.splice(evicted.begin(), resident, victim);
+            stats.evictions++;
+            victim->evict();
+        }
+    }
+
+    void setBudget(size_t bytes) {
+        budgetBytes = bytes;
+    }
+
+    size_t budget() const {
+        return budgetBytes;
+    }
+
+    size_t residentMemory() const {
+        return residentBytes;
+    }
+
+    uint64_t currentFrame() const {
+        return frame;
+    }
+
+    const Stats& counters() const {
+        return stats;
+    }
+};
@@ -0,0 +1,305 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+#include "Core/JobSystem.hpp"
+#include "Core/MappedFile.hpp"
+#include "Core/Profiler.hpp"
+#include "Render/Tilemap.hpp"
+#include "Render/TilemapFile.hpp"
+
+// A tile world read from a mapped .tmap file and kept in memory only around the camera.
+// update() asks for every chunk within radius chunks of the view, nearest first; the missing ones
+// are decoded by jobs into a fixed pool of slots, and when the pool is full the chunk unseen for
+// longest is dropped. Memory is the pool (slotCount chunks of tiles) whatever the size of the world,
+// plus the pages of the file the OS chooses to keep mapped, which it can drop without writing back.
+// A chunk still loading is simply not drawn; asking for the margin ahead of the view is what keeps
+// that from showing. Used as the map of a TilemapRenderer<TileStreamer>.
+// Not synchronized: update() and the renderer run on one thread, the jobs touch only loading slots.
+class TileStreamer {
+public:
+    static constexpr uint32_t NONE = Tilemap::NONE;
+    static constexpr int CHUNK_SIZE = Tilemap::CHUNK_SIZE;
+
+    struct Stats {
+        uint64_t loads = 0;
+        uint64_t evictions = 0;
+        uint64_t failures = 0;      // chunks whose block was corrupt, drawn as empty
+        uint64_t deferred = 0;      // chunks not started because of the in-flight cap or a full pool
+        uint32_t missing = 0;       // chunks under the view that were not ready at the last update
+        uint32_t inFlight = 0;
+    };
+
+private:
+    enum SlotState : uint8_t { FREE, LOADING, DECODED, FAILED, READY };
+
+    struct Slot {
+        std::atomic<uint8_t> state{ FREE }; // LOADING -> DECODED or FAILED is the decode job's only write
+        int chunkX = 0, chunkY = 0;
+        uint32_t version = 0;               // bumped every time the slot gets new tiles
+        uint64_t lastUsedFrame = 0;
+        uint32_t newer = NONE, older = NONE; // LRU links between READY slots
+    };
+
+    JobSystem& jobs;
+    MappedFile file;
+    const TilemapFileHeader* header = nullptr;
+    const TilemapChunkEntry* entries = nullptr;
+    float tileSize;
+    glm::vec2 origin;
+    int radius;
+    uint32_t maxInFlight;
+
+    std::vector<Slot> slots;
+    std::vector<uint16_t> tiles;        // TILEMAP_CHUNK_TILES per slot
+    std::vector<uint32_t> freeSlots;
+    std::vector<uint32_t> loading;
+    std::unordered_map<uint64_t, uint32_t> resident; // chunk key -> slot, loading or ready
+    uint32_t mostRecent = NONE, leastRecent = NONE;
+    std::vector<glm::ivec2> wanted;
+    JobCounter pending;
+    uint64_t frame = 0;
+    Stats stats;
+
+public:
+    // slotCount bounds memory and has to cover the view plus the radius, or chunks at the far edge
+    // keep evicting each other. radius is in chunks around the view rect.
+    TileStreamer(JobSystem& jobs, const std::string& path, float tileSize, const glm::vec2& origin, uint32_t slotCount, int radius = 2, uint32_t maxInFlight = 16)
+        : jobs(jobs), tileSize(tileSize), origin(origin), radius(std::max(radius, 0)), maxInFlight(std::max(maxInFlight, 1u)),
+          slots(slotCount), tiles(size_t(slotCount) * TILEMAP_CHUNK_TILES) {
+        if (!file.open(path))
+        {
+            std::cout << "Failed to map tilemap " << path << "\n";
+            return;
+        }
+        header = readTilemapFile(file, entries);
+        if (!header)
+        {
+            std::cout << "Not a valid tilemap file: " << path << "\n";
+            return;
+        }
+        freeSlots.reserve(slotCount);
+        for (uint32_t i = slotCount; i-- > 0;)
+            freeSlots.push_back(i);
+        resident.reserve(slotCount);
+    }
+
+    ~TileStreamer() {
+        jobs.wait(pending);
+    }
+
+    TileStreamer(const TileStreamer&) = delete;
+    TileStreamer& operator=(const TileStreamer&) = delete;
+
+    bool isOpen() const { return header != nullptr; }
+    int getWidth() const { return header ? int(header->width) : 0; }
+    int getHeight() const { return header ? int(header->height) : 0; }
+    int getChunksX() const { return header ? int(header->chunksX) : 0; }
+    int getChunksY() const { return header ? int(header->chunksY) : 0; }
+    float getTileSize() const { return tileSize; }
+    const glm::vec2& getOrigin() const { return origin; }
+    const Stats& counters() const { return stats; }
+
+    size_t residentMemory() const {
+        return tiles.size() * sizeof(uint16_t) + slots.size() * sizeof(Slot);
+    }
+
+    // Call once per frame before drawing with the world rect the camera sees
+    void update(const glm::vec2& viewMin, const glm::vec2& viewMax) {
+        PROFILE_SCOPE("Tile streaming");
+        frame++;
+        if (!header)
+            return;
+        collect();
+
+        glm::ivec2 lo, hi;
+        chunkRange(viewMin, viewMax, lo, hi);
+        glm::ivec2 wantLo = glm::max(lo - radius, glm::ivec2(0));
+        glm::ivec2 wantHi = glm::min(hi + radius, glm::ivec2(getChunksX() - 1, getChunksY() - 1));
+        glm::vec2 center = (viewMin + viewMax) * 0.5f;
+        wanted.clear();
+        for (int y = wantLo.y; y <= wantHi.y; y++)
+            for (int x = wantLo.x; x <= wantHi.x; x++)
+                wanted.push_back(glm::ivec2(x, y));
+        // nearest first, so the view fills before the margin when loads are capped
+        float chunkWorld = tileSize * CHUNK_SIZE;
+        auto distance = [&](const glm::ivec2& chunk) {
+            glm::vec2 d = chunkOrigin(chunk.x, chunk.y) + chunkWorld * 0.5f - center;
+            return d.x * d.x + d.y * d.y;
+        };
+        std::sort(wanted.begin(), wanted.end(), [&](const glm::ivec2& a, const glm::ivec2& b) { return distance(a) < distance(b); });
+
+        for (const glm::ivec2& chunk : wanted)
+        {
+            auto it = resident.find(key(chunk.x, chunk.y));
+            if (it != resident.end())
+            {
+                Slot& slot = slots[it->second];
+                slot.lastUsedFrame = frame;
+                if (slot.state.load(std::memory_order_relaxed) == READY)
+                    touch(it->second);
+                continue;
+            }
+            uint32_t slot = loading.size() < maxInFlight ? acquire() : NONE;
+            if (slot == NONE)
+            {
+                stats.deferred++;
+                continue;
+            }
+            load(slot, chunk.x, chunk.y);
+        }
+        // with no background worker the jobs would sit until someone waits, so decode them here
+        if (jobs.workerCount() == 1)
+            jobs.wait(pending);
+        collect();
+
+        stats.missing = 0;
+        for (int y = lo.y; y <= hi.y; y++)
+            for (int x = lo.x; x <= hi.x; x++)
+                if (chunkSlot(x, y) == NONE)
+                    stats.missing++;
+        stats.inFlight = uint32_t(loading.size());
+    }
+
+    // TilemapRenderer interface
+
+    size_t chunkSlots() const {
+        return slots.size();
+    }
+
+    // the slot holding the chunk's tiles, NONE while it is not loaded
+    uint32_t chunkSlot(int chunkX, int chunkY) const {
+        auto it = resident.find(key(chunkX, chunkY));
+        if (it == resident.end() || slots[it->second].state.load(std::memory_order_relaxed) != READY)
+            return NONE;
+        return it->second;
+    }
+
+    uint32_t slotVersion(uint32_t slot) const {
+        return slots[slot].version;
+    }
+
+    // only valid for a chunk whose chunkSlot() is not NONE, see Tilemap::packChunk
+    size_t packChunk(int chunkX, int chunkY, uint32_t frameCount, std::vector<uint32_t>& out) const {
+        return Tilemap::packTiles(slotTiles(chunkSlot(chunkX, chunkY)), frameCount, out);
+    }
+
+    const uint16_t* slotTiles(uint32_t slot) const {
+        return tiles.data() + size_t(slot) * TILEMAP_CHUNK_TILES;
+    }
+
+    glm::vec2 chunkOrigin(int chunkX, int chunkY) const {
+        return origin + glm::vec2(float(chunkX), float(chunkY)) * (tileSize * CHUNK_SIZE);
+    }
+
+    // same as Tilemap::chunkRange
+    void chunkRange(const glm::vec2& viewMin, const glm::vec2& viewMax, glm::ivec2& lo, glm::ivec2& hi) const {
+        float inverseChunk = 1.0f / (tileSize * CHUNK_SIZE);
+        glm::vec2 first = glm::floor((viewMin - origin) * inverseChunk);
+        glm::vec2 last = glm::floor((viewMax - origin) * inverseChunk);
+        lo = glm::ivec2(glm::max(first, glm::vec2(0.0f)));
+        hi = glm::ivec2(glm::min(last, glm::vec2(float(getChunksX() - 1), float(getChunksY() - 1))));
+    }
+
+private:
+    static uint64_t key(int chunkX, int chunkY) {
+        return uint64_t(uint32_t(chunkY)) << 32 | uint32_t(chunkX);
+    }
+
+    // A free slot, else the least recently used one not wanted this frame, else NONE
+    uint32_t acquire() {
+        if (!freeSlots.empty())
+        {
+            uint32_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+        if (leastRecent == NONE || slots[leastRecent].lastUsedFrame == frame)
+            return NONE;
+        uint32_t slot = leastRecent;
+        unlink(slot);
+        resident.erase(key(slots[slot].chunkX, slots[slot].chunkY));
+        stats.evictions++;
+        return slot;
+    }
+
+    void load(uint32_t index, int chunkX, int chunkY) {
+        Slot& slot = slots[index];
+        slot.chunkX = chunkX;
+        slot.chunkY = chunkY;
+        slot.lastUsedFrame = frame;
+        slot.state.store(LOADING, std::memory_order_relaxed);
+        resident[key(chunkX, chunkY)] = index;
+        loading.push_back(index);
+        const TilemapChunkEntry& entry = entries[size_t(chunkY) * header->chunksX + chunkX];
+        uint16_t* out = tiles.data() + size_t(index) * TILEMAP_CHUNK_TILES;
+        jobs.run([this, &entry, out, index]() {
+            PROFILE_SCOPE("Tile chunk decode");
+            bool decoded = decodeTilemapChunk(file, entry, out);
+            slots[index].state.store(decoded ? DECODED : FAILED, std::memory_order_release);
+        }, pending);
+    }
+
+    // Picks up the decodes that finished since the last call
+    void collect() {
+        for (size_t i = 0; i < loading.size();)
+        {
+            uint32_t index = loading[i];
+            Slot& slot = slots[index];
+            uint8_t state = slot.state.load(std::memory_order_acquire);
+            if (state == LOADING)
+            {
+                i++;
+                continue;
+            }
+            loading[i] = loading.back();
+            loading.pop_back();
+            if (state == FAILED)
+            {
+                // drawn as empty rather than retried every frame, until it is evicted
+                std::cout << "Corrupt tilemap chunk " << slot.chunkX << ", " << slot.chunkY << "\n";
+                uint16_t* out = tiles.data() + size_t(index) * TILEMAP_CHUNK_TILES;
+                std::fill(out, out + TILEMAP_CHUNK_TILES, Tilemap::EMPTY);
+                stats.failures++;
+            }
+            slot.state.store(READY, std::memory_order_relaxed);
+            slot.version++;
+            touch(index);
+            stats.loads++;
+        }
+    }
+
+    void unlink(uint32_t index) {
+        Slot& slot = slots[index];
+        if (slot.newer != NONE)
+            slots[slot.newer].older = slot.older;
+        else if (mostRecent == index)
+            mostRecent = slot.older;
+        if (slot.older != NONE)
+            slots[slot.older].newer = slot.newer;
+        else if (leastRecent == index)
+            leastRecent = slot.newer;
+        slot.newer = slot.older = NONE;
+    }
+
+    // moves a READY slot to the most recently used end
+    void touch(uint32_t index) {
+        if (mostRecent == index)
+            return;
+        unlink(index);
+        Slot& slot = slots[index];
+        slot.older = mostRecent;
+        if (mostRecent != NONE)
+            slots[mostRecent].newer = index;
+        mostRecent = index;
+        if (leastRecent == NONE)
+            leastRecent = index;
+    }
+};
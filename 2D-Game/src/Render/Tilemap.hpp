@@ -0,0 +1,140 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <iostream>
+
+// Grid of tiles, each a SpriteSheet frame index or EMPTY, split into CHUNK_SIZE x CHUNK_SIZE chunks.
+// Every chunk carries a version bumped by set(), so whoever caches something per chunk (the
+// TilemapRenderer's GPU buffers) knows exactly which chunks to rebuild. Tile (0, 0) has its
+// lower left corner at origin and y goes up. The chunk slots the renderer caches by are simply the
+// chunks here; a TileStreamer hands out the same interface over a pool it reuses.
+// Not synchronized: it belongs to the thread that draws it, like the rest of the GL-side state.
+class Tilemap {
+public:
+    static constexpr int CHUNK_SIZE = 32;
+    static constexpr uint16_t EMPTY = UINT16_MAX;
+    static constexpr uint32_t NONE = UINT32_MAX; // chunkSlot() of a chunk not in memory, never returned by a Tilemap
+
+private:
+    int width = 0, height = 0;
+    int chunksX = 0, chunksY = 0;
+    float tileSize = 1.0f;
+    glm::vec2 origin = glm::vec2(0.0f);
+    std::vector<uint16_t> tiles;     // chunk by chunk, row-major inside each, so a chunk is contiguous
+    std::vector<uint32_t> versions;  // per chunk
+
+public:
+    Tilemap(int width, int height, float tileSize, const glm::vec2& origin = glm::vec2(0.0f))
+        : width(std::max(width, 0)), height(std::max(height, 0)), tileSize(tileSize), origin(origin) {
+        chunksX = (this->width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        chunksY = (this->height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        tiles.assign(size_t(chunksX) * chunksY * CHUNK_SIZE * CHUNK_SIZE, EMPTY);
+        versions.assign(size_t(chunksX) * chunksY, 0);
+    }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getChunksX() const { return chunksX; }
+    int getChunksY() const { return chunksY; }
+    float getTileSize() const { return tileSize; }
+    const glm::vec2& getOrigin() const { return origin; }
+
+    size_t chunkCount() const {
+        return versions.size();
+    }
+
+    uint16_t get(int x, int y) const {
+        if (x < 0 || y < 0 || x >= width || y >= height)
+            return EMPTY;
+        return tiles[tileIndex(x, y)];
+    }
+
+    void set(int x, int y, uint16_t frame) {
+        if (x < 0 || y < 0 || x >= width || y >= height)
+            return;
+        uint16_t& tile = tiles[tileIndex(x, y)];
+        if (tile == frame)
+            return;
+        tile = frame;
+        versions[size_t(y / CHUNK_SIZE) * chunksX + x / CHUNK_SIZE]++;
+    }
+
+    uint32_t chunkVersion(int chunkX, int chunkY) const {
+        return versions[size_t(chunkY) * chunksX + chunkX];
+    }
+
+    size_t chunkSlots() const {
+        return versions.size();
+    }
+
+    uint32_t chunkSlot(int chunkX, int chunkY) const {
+        return uint32_t(size_t(chunkY) * chunksX + chunkX);
+    }
+
+    uint32_t slotVersion(uint32_t slot) const {
+        return versions[slot];
+    }
+
+    // the CHUNK_SIZE * CHUNK_SIZE tiles of a chunk, row-major; the part past the map edge is EMPTY
+    const uint16_t* chunkTiles(int chunkX, int chunkY) const {
+        return tiles.data() + (size_t(chunkY) * chunksX + chunkX) * CHUNK_SIZE * CHUNK_SIZE;
+    }
+
+    uint16_t* chunkTiles(int chunkX, int chunkY) {
+        return tiles.data() + (size_t(chunkY) * chunksX + chunkX) * CHUNK_SIZE * CHUNK_SIZE;
+    }
+
+    // for writers that fill a whole chunk through chunkTiles()
+    void touchChunk(int chunkX, int chunkY) {
+        versions[size_t(chunkY) * chunksX + chunkX]++;
+    }
+
+    glm::vec2 chunkOrigin(int chunkX, int chunkY) const {
+        return origin + glm::vec2(float(chunkX), float(chunkY)) * (tileSize * CHUNK_SIZE);
+    }
+
+    // Chunks overlapping the world rect [viewMin, viewMax], clamped to the map; empty when
+    // lo > hi. Arithmetic only, so the cost does not depend on the size of the map.
+    void chunkRange(const glm::vec2& viewMin, const glm::vec2& viewMax, glm::ivec2& lo, glm::ivec2& hi) const {
+        float inverseChunk = 1.0f / (tileSize * CHUNK_SIZE);
+        glm::vec2 first = glm::floor((viewMin - origin) * inverseChunk);
+        glm::vec2 last = glm::floor((viewMax - origin) * inverseChunk);
+        lo = glm::ivec2(glm::max(first, glm::vec2(0.0f)));
+        hi = glm::ivec2(glm::min(last, glm::vec2(float(chunksX - 1), float(chunksY - 1))));
+    }
+
+    // One packed instance per non-empty tile of the chunk: x in bits 0-7, y in bits 8-15,
+    // frame in bits 16-31. Tiles whose frame is not below frameCount, the size of the sheet's
+    // table, are left out like empty ones. Returns how many were written to out.
+    size_t packChunk(int chunkX, int chunkY, uint32_t frameCount, std::vector<uint32_t>& out) const {
+        return packTiles(chunkTiles(chunkX, chunkY), frameCount, out);
+    }
+
+    static size_t packTiles(const uint16_t* chunk, uint32_t frameCount, std::vector<uint32_t>& out) {
+        out.clear();
+        size_t invalid = 0;
+        for (uint32_t y = 0; y < CHUNK_SIZE; y++)
+            for (uint32_t x = 0; x < CHUNK_SIZE; x++)
+            {
+                uint16_t frame = chunk[y * CHUNK_SIZE + x];
+                if (frame == EMPTY)
+                    continue;
+                if (frame < frameCount)
+                    out.push_back(x | y << 8 | uint32_t(frame) << 16);
+                else
+                    invalid++;
+            }
+        if (invalid)
+            std::cout << "TILEMAP::" << invalid << " tiles of a chunk use frames past the sheet's " << frameCount << ", left empty" << "\n";
+        return out.size();
+    }
+
+private:
+    size_t tileIndex(int x, int y) const {
+        size_t chunk = size_t(y / CHUNK_SIZE) * chunksX + x / CHUNK_SIZE;
+        return chunk * CHUNK_SIZE * CHUNK_SIZE + size_t(y % CHUNK_SIZE) * CHUNK_SIZE + x % CHUNK_SIZE;
+    }
+};
@@ -0,0 +1,166 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include "Core/Lz4.hpp"
+#include "Core/MappedFile.hpp"
+#include "Render/Tilemap.hpp"
+
+// .tmap container for worlds too big to hold: header, one TilemapChunkEntry per chunk in row-major
+// chunk order, then an LZ4 block per chunk holding its Tilemap::CHUNK_SIZE^2 frames as little
+// endian uint16 (EMPTY included), 16 byte aligned like the .ctex levels. Chunks with identical
+// tiles share one block, and an all-EMPTY chunk has none, so sky and repeated terrain cost 8 bytes.
+// Meant to be mapped: opening reads only the header, a chunk touches its entry and its block.
+struct TilemapFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width, height; // tiles
+    uint32_t chunkSize;
+    uint32_t chunksX, chunksY;
+    uint32_t reserved;
+};
+
+struct TilemapChunkEntry {
+    uint32_t block; // offset from the start of the file in 16 byte units, reaches 64 GB
+    uint32_t size;  // compressed bytes, 0 for an all-EMPTY chunk
+};
+
+inline constexpr char TILEMAP_FILE_MAGIC[4] = { 'T', 'M', 'A', 'P' };
+inline constexpr uint32_t TILEMAP_FILE_VERSION = 1;
+inline constexpr size_t TILEMAP_CHUNK_TILES = size_t(Tilemap::CHUNK_SIZE) * Tilemap::CHUNK_SIZE;
+
+// Validates a mapped .tmap file and returns its header and chunk table, or nullptr if it is
+// malformed. Blocks are bounds checked when decoded, not here, so opening stays O(1).
+inline const TilemapFileHeader* readTilemapFile(const MappedFile& file, const TilemapChunkEntry*& chunks) {
+    if (file.size() < sizeof(TilemapFileHeader))
+        return nullptr;
+    auto header = reinterpret_cast<const TilemapFileHeader*>(file.data());
+    uint64_t chunkCount = uint64_t(header->chunksX) * header->chunksY;
+    if (std::memcmp(header->magic, TILEMAP_FILE_MAGIC, 4) != 0 || header->version != TILEMAP_FILE_VERSION ||
+        header->chunkSize != uint32_t(Tilemap::CHUNK_SIZE) ||
+        header->chunksX != (uint64_t(header->width) + Tilemap::CHUNK_SIZE - 1) / Tilemap::CHUNK_SIZE ||
+        header->chunksY != (uint64_t(header->height) + Tilemap::CHUNK_SIZE - 1) / Tilemap::CHUNK_SIZE ||
+        file.size() < sizeof(TilemapFileHeader) + chunkCount * sizeof(TilemapChunkEntry))
+        return nullptr;
+    chunks = reinterpret_cast<const TilemapChunkEntry*>(file.data() + sizeof(TilemapFileHeader));
+    return header;
+}
+
+// Decodes one chunk into TILEMAP_CHUNK_TILES frames; false if its block is out of the file or corrupt
+inline bool decodeTilemapChunk(const MappedFile& file, const TilemapChunkEntry& entry, uint16_t* tiles) {
+    if (entry.size == 0)
+    {
+        std::fill(tiles, tiles + TILEMAP_CHUNK_TILES, Tilemap::EMPTY);
+        return true;
+    }
+    uint64_t offset = uint64_t(entry.block) * 16;
+    if (offset + entry.size > file.size())
+        return false;
+    return Lz4::decompress(file.data() + offset, entry.size, reinterpret_cast<uint8_t*>(tiles), TILEMAP_CHUNK_TILES * sizeof(uint16_t));
+}
+
+namespace TilemapFileDetail {
+
+    inline uint64_t hashTiles(const uint16_t* tiles) {
+        uint64_t hash = 0;
+        for (size_t i = 0; i < TILEMAP_CHUNK_TILES; i += 4)
+        {
+            uint64_t word;
+            std::memcpy(&word, tiles + i, sizeof(word));
+            hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+            hash ^= hash >> 29;
+        }
+        return hash;
+    }
+}
+
+// Streams a width x height world to path one chunk at a time, so the world never has to exist in
+// memory. source(chunkX, chunkY, scratch) returns the chunk's TILEMAP_CHUNK_TILES frames, either
+// written into scratch or any array it owns, or nullptr when the chunk is all EMPTY.
+// The chunk table is kept in memory while writing, 8 bytes per chunk.
+template<typename Source>
+bool writeTilemapFile(const std::string& path, uint32_t width, uint32_t height, Source&& source) {
+    // distinct chunks kept for sharing blocks, beyond this new chunks are only written
+    const size_t MAX_SHARED = 16384;
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Failed to open " << path << " for writing" << "\n";
+        return false;
+    }
+    TilemapFileHeader header = {};
+    std::memcpy(header.magic, TILEMAP_FILE_MAGIC, 4);
+    header.version = TILEMAP_FILE_VERSION;
+    header.width = width;
+    header.height = height;
+    header.chunkSize = Tilemap::CHUNK_SIZE;
+    header.chunksX = (width + Tilemap::CHUNK_SIZE - 1) / Tilemap::CHUNK_SIZE;
+    header.chunksY = (height + Tilemap::CHUNK_SIZE - 1) / Tilemap::CHUNK_SIZE;
+    std::vector<TilemapChunkEntry> table(size_t(header.chunksX) * header.chunksY, TilemapChunkEntry{ 0, 0 });
+
+    // blocks go after the table, which is written last once every entry is known
+    uint64_t position = sizeof(TilemapFileHeader) + table.size() * sizeof(TilemapChunkEntry);
+    file.seekp(std::streamoff(position));
+
+    struct Shared {
+        std::vector<uint16_t> tiles;
+        TilemapChunkEntry entry;
+    };
+    std::unordered_multimap<uint64_t, Shared> shared;
+    std::vector<uint16_t> scratch(TILEMAP_CHUNK_TILES);
+    std::vector<uint8_t> compressed(Lz4::compressBound(TILEMAP_CHUNK_TILES * sizeof(uint16_t)));
+    size_t uniqueChunks = 0;
+    for (uint32_t cy = 0; cy < header.chunksY; cy++)
+        for (uint32_t cx = 0; cx < header.chunksX; cx++)
+        {
+            const uint16_t* tiles = source(cx, cy, scratch.data());
+            if (!tiles)
+                continue;
+            TilemapChunkEntry& entry = table[size_t(cy) * header.chunksX + cx];
+            uint64_t hash = TilemapFileDetail::hashTiles(tiles);
+            bool found = false;
+            auto range = shared.equal_range(hash);
+            for (auto it = range.first; it != range.second && !found; ++it)
+                if (std::memcmp(it->second.tiles.data(), tiles, TILEMAP_CHUNK_TILES * sizeof(uint16_t)) == 0)
+                {
+                    entry = it->second.entry;
+                    found = true;
+                }
+            if (found)
+                continue;
+
+            size_t size = Lz4::compress(reinterpret_cast<const uint8_t*>(tiles), TILEMAP_CHUNK_TILES * sizeof(uint16_t), compressed.data(), compressed.size());
+            position = (position + 15) & ~uint64_t(15);
+            if (position / 16 > UINT32_MAX)
+            {
+                std::cout << "Tilemap " << path << " is over 64 GB" << "\n";
+                return false;
+            }
+            static const char zeros[16] = {};
+            file.write(zeros, std::streamsize(position - uint64_t(file.tellp())));
+            file.write(reinterpret_cast<const char*>(compressed.data()), std::streamsize(size));
+            entry = { uint32_t(position / 16), uint32_t(size) };
+            position += size;
+            uniqueChunks++;
+            if (shared.size() < MAX_SHARED)
+                shared.insert({ hash, Shared{ std::vector<uint16_t>(tiles, tiles + TILEMAP_CHUNK_TILES), entry } });
+        }
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()), std::streamsize(table.size() * sizeof(TilemapChunkEntry)));
+    if (!file)
+    {
+        std::cout << "Failed to write " << path << "\n";
+        return false;
+    }
+    std::cout << "Wrote " << path << " (" << width << "x" << height << " tiles, " << table.size() << " chunks, "
+              << uniqueChunks << " blocks, " << position / 1024 << " KB)" << "\n";
+    return true;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <vector>
+#include <cstdint>
+
+#include "Render/Shader.hpp"
+#include "Render/SpriteSheet.hpp"
+#include "Render/RenderStats.hpp"
+#include "Render/Tilemap.hpp"
+#include "Core/Profiler.hpp"
+
+// Draws a tile map chunk by chunk with the Tilemap shader. Each chunk's packed tiles live in an
+// immutable buffer made the first time the chunk is seen and remade only when its version moves,
+// so a frame uploads nothing unless a visible tile changed. Only the chunks under the camera rect
+// are visited, found by arithmetic rather than a scan, which keeps a frame's cost tied to the
+// screen and not to the size of the map. One draw call per visible non-empty chunk, six vertices
+// per tile generated in the vertex shader from the packed tile.
+// Map is a Tilemap or a TileStreamer: buffers are cached per chunkSlot(), of which there are
+// chunkSlots(), so a streamed world keeps as many as the streamer keeps chunks in memory.
+// Tiles are checked against the sheet's frame table when their chunk is packed, so a bad frame
+// id in a map file is dropped there rather than read past the table by the shader.
+template<typename Map = Tilemap>
+class TilemapRenderer {
+public:
+    static constexpr unsigned int TILE_BINDING = 5; // SSBO binding of the chunk's tiles in Tilemap.vert
+
+private:
+    struct Chunk {
+        GLuint buffer = 0;
+        uint32_t tileCount = 0;
+        uint32_t version = 0;
+        bool built = false;
+    };
+
+    const Map& tilemap;
+    const SpriteSheet& sheet;
+    std::vector<Chunk> chunks;
+    std::vector<uint32_t> packed;
+    GLuint vao = 0; // core profile wants one bound even without attributes
+
+    GLint viewLocation = -1, projectionLocation = -1, chunkOriginLocation = -1, tileSizeLocation = -1;
+    GLuint locationsFor = 0;
+
+public:
+    // sheet is the one whose frames the tiles index, it has to outlive the renderer
+    TilemapRenderer(const Map& tilemap, const SpriteSheet& sheet) : tilemap(tilemap), sheet(sheet), chunks(tilemap.chunkSlots()) {
+        glCreateVertexArrays(1, &vao);
+    }
+
+    ~TilemapRenderer() {
+        for (Chunk& chunk : chunks)
+            if (chunk.buffer)
+                glDeleteBuffers(1, &chunk.buffer);
+        glDeleteVertexArrays(1, &vao);
+    }
+
+    TilemapRenderer(const TilemapRenderer&) = delete;
+    TilemapRenderer& operator=(const TilemapRenderer&) = delete;
+
+    // viewMin and viewMax are the world rect the camera sees. The sheet's frame table has to be
+    // bound at binding 3 and the sheet's texture at unit 0, as for the sprites.
+    void draw(const Shader& shader, const glm::mat4& view, const glm::mat4& projection, const glm::vec2& viewMin, const glm::vec2& viewMax, RenderStats& stats) {
+        PROFILE_SCOPE("Tilemap");
+        glm::ivec2 lo, hi;
+        tilemap.chunkRange(viewMin, viewMax, lo, hi);
+        if (lo.x > hi.x || lo.y > hi.y)
+            return;
+
+        shader.use();
+        if (locationsFor != shader.ID)
+        {
+            viewLocation = glGetUniformLocation(shader.ID, "view");
+            projectionLocation = glGetUniformLocation(shader.ID, "projection");
+            chunkOriginLocation = glGetUniformLocation(shader.ID, "chunkOrigin");
+            tileSizeLocation = glGetUniformLocation(shader.ID, "tileSize");
+            locationsFor = shader.ID;
+        }
+        glUniformMatrix4fv(viewLocation, 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, glm::value_ptr(projection));
+        glUniform1f(tileSizeLocation, tilemap.getTileSize());
+        glBindVertexArray(vao);
+        stats.stateChanges += 2;
+
+        for (int y = lo.y; y <= hi.y; y++)
+            for (int x = lo.x; x <= hi.x; x++)
+            {
+                uint32_t slot = tilemap.chunkSlot(x, y);
+                if (slot == Map::NONE)
+                    continue;
+                Chunk& chunk = chunks[slot];
+                uint32_t version = tilemap.slotVersion(slot);
+                if (!chunk.built || chunk.version != version)
+                    rebuild(chunk, x, y, version, stats);
+                if (!chunk.tileCount)
+                    continue;
+                glm::vec2 origin = tilemap.chunkOrigin(x, y);
+                glUniform2f(chunkOriginLocation, origin.x, origin.y);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, TILE_BINDING, chunk.buffer);
+                glDrawArrays(GL_TRIANGLES, 0, GLsizei(chunk.tileCount * 6));
+                stats.stateChanges++;
+                stats.drawCalls++;
+                stats.sprites += chunk.tileCount;
+            }
+    }
+
+private:
+    void rebuild(Chunk& chunk, int x, int y, uint32_t version, RenderStats& stats) {
+        PROFILE_SCOPE("Tilemap chunk build");
+        // immutable storage cannot be respecified, a changed chunk gets a new buffer
+        if (chunk.buffer)
+            glDeleteBuffers(1, &chunk.buffer);
+        chunk.buffer = 0;
+        chunk.tileCount = uint32_t(tilemap.packChunk(x, y, uint32_t(sheet.frameCount()), packed));
+        if (chunk.tileCount)
+        {
+            glCreateBuffers(1, &chunk.buffer);
+            glNamedBufferStorage(chunk.buffer, packed.size() * sizeof(uint32_t), packed.data(), 0);
+            stats.bytesUploaded += packed.size() * sizeof(uint32_t);
+        }
+        chunk.version = version;
+        chunk.built = true;
+    }
+};